@@ -6,7 +6,7 @@
 #include "src/includes.h"    // Contains other standard Arduino libraries and class header includes
 #include "config.h"          // Contains extern declarations for feature flags
 #include "calibration.h"     // Contains extern declaration for calibrations array
-#include "src/definitions.h" // Contains extern declarations for global objects like wifi, pwm, huyangFace, etc.
+#include "src/definitions.h" // Contains extern declarations for global objects like wifi, pwmBus, huyangFace, etc.
 
 // --- GLOBAL DEFINITIONS (allocate memory for extern-declared variables/objects) ---
 // These variables and objects are now defined *once* here.
@@ -31,6 +31,8 @@ char calibrations[] = "{\"neck\":{\"rotation\":0,\"tiltForward\":0,\"tiltSideway
 // From definitions.h (global objects and time variables):
 unsigned long currentMillis = 0;
 unsigned long previousMillisIPAdress = 0;
+unsigned long previousManualInput = 0;
+uint16_t pendingPoseDuration = 0;
 
 JxWifiManager *wifi = new JxWifiManager();
 
@@ -42,13 +44,30 @@ Arduino_GFX *leftEye = new Arduino_GC9A01(leftBus, 0 /* RST */);
 Arduino_DataBus *rightBus = new Arduino_HWSPI(0 /* DC (D3) */, 15 /* CS (D8) */);
 Arduino_GFX *rightEye = new Arduino_GC9A01(rightBus, 0 /* RST */);
 
-// PWM Servo Driver (PCA9685) instance
-Adafruit_PWMServoDriver *pwm = new Adafruit_PWMServoDriver(0x40);
+// Pulse calibration of every servo channel, loaded from LittleFS by the web server
+ServoCalibration *servoCalibration = new ServoCalibration();
+// All PCA9685 boards (PwmBoardAddresses in config.h), collects all servo values and sends only the changed ones
+PwmBus *pwmBus = new PwmBus(PwmBoardsPerTick, I2cBudgetPerTick);
+// Axis table for all servo movements, must be created before the subsystems register their axes
+static_assert(HuyangNeck_AXES + HuyangBody_AXES <= MotionAxis_MAX_AXES, "Neck and body need more axes than MotionAxis_MAX_AXES");
+MotionAxis *motion = new MotionAxis(pwmBus);
+// Deadband and smoothing of the manual inputs from the web interface
+InputFilter *inputFilter = new InputFilter();
+// Named poses on LittleFS, recalled by the web interface
+PoseLibrary *poseLibrary = new PoseLibrary();
+// Playout of joystick packets streamed by the web interface, hides Wi-Fi jitter
+InputPlayout *neckStream = new InputPlayout();
+InputPlayout *bodyStream = new InputPlayout();
+// Control tick clock, the rate is set in config.h
+MotionClock *motionClock = new MotionClock(ControlTickRate);
 
 // Huyang Robot Subsystem Instances
 HuyangFace *huyangFace = new HuyangFace(leftEye, rightEye); // Manages eye animations
-HuyangBody *huyangBody = new HuyangBody(pwm); // Manages body servos and chest lights
-HuyangNeck *huyangNeck = new HuyangNeck(pwm); // Manages neck servos
+HuyangBody *huyangBody = new HuyangBody(pwmBus, motion); // Manages body servos and chest lights
+HuyangNeck *huyangNeck = new HuyangNeck(pwmBus, motion); // Manages neck servos
+HuyangGaze *huyangGaze = new HuyangGaze(huyangNeck, huyangBody); // Solves look-at points into neck and body moves
+HuyangGesture *huyangGesture = new HuyangGesture(motion, huyangNeck, huyangBody); // Nod, shake and other gestures on the gesture layer
+HuyangSequencer *huyangSequencer = new HuyangSequencer(motionClock, huyangNeck, huyangBody, huyangFace); // Plays clips from LittleFS
 HuyangAudio *huyangAudio = new HuyangAudio(); // Audio system
 
 // Web Server instance, using the port defined in config.h
@@ -29,6 +29,52 @@
 // Webserver Port default is 80. If you want a different Port, change it
 #define WebServerPort 80
 
+// Motion Option
+// How often per second servo positions are calculated and sent to the PCA9685.
+// Movements are time-based and keep their speed at any rate, the PCA9685 only
+// outputs a new pulse every 1/60 s so higher values mostly cost CPU and I2C time.
+#define ControlTickRate 60
+
+// I2C addresses of the PCA9685 servo boards, 0x40 is a board without solder jumpers.
+// Servos on the first board use channels 0-15, on the second 16-31 (PwmBus_CHANNEL in PwmBus.h). Example: {0x40, 0x41}
+#define PwmBoardAddresses {0x40}
+
+// How many boards are sent per control tick. Changes of further boards wait for the next tick,
+// so the I2C time of one tick stays the same when boards are added.
+#define PwmBoardsPerTick 1
+
+// I2C clock in Hz. The PCA9685 handles 400000 (fast mode) and up to 1000000 with short wires.
+#define I2cClock 400000
+
+// Estimated I2C time in microseconds one control tick may spend on servo updates. The servos that are
+// furthest from their target go first, the others follow in the next tick. At 400 kHz all 16 channels
+// of a board take about 2000 us. The serial report shows a histogram of the real time per tick.
+#define I2cBudgetPerTick 1500
+
+// Duration in ms of a manual move from the web interface. Neck, body and monocle
+// axes that change together arrive together, the body may take longer to keep its speed limits.
+// Input that changes faster than this (joystick) is followed as one continuous stream instead.
+#define ManualMoveDuration 1000
+
+// Time in ms after which a servo that has not moved is switched off (full-off), 0 = always hold.
+// A switched off servo stops drawing current and getting warm, but no longer holds its position
+// against load, so only use this if the head and body stay put without power. It is powered again on its next move.
+#define ServoHoldTime 0
+
+// Conditioning of the manual inputs (sliders and joystick) before they become moves, see InputFilter.h.
+// Deadband and hysteresis are in slider units (-100 to 100), changes within them count as jitter.
+// The filter smooths a resting input at InputMinCutoff Hz (Q8, 256 = 1 Hz) and opens up by InputBeta
+// (Q16 Hz per unit/s) the faster it moves. The body is heavier, it gets a wider deadband.
+#define InputDeadband 1
+#define InputHysteresis 1
+#define InputBodyDeadband 2
+#define InputMinCutoff 256
+#define InputBeta 3277
+
+// Weight of the idle motion while the droid is steered manually, 0 (off) to 256 (as in automatic mode).
+// The idle layer is added on top of the manual position, so the droid keeps moving a little while you steer.
+#define IdleWeightManual 64
+
 // System Option
 // Here you can enable/disable some sub-sections of the software to match your build
 // To disable an option, change: true; to false;
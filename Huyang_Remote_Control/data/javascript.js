@@ -86,9 +86,16 @@ function changeAutomatic(newState) {
     sendData(data);
 }
 
+// Joystick packets carry a sequence number and the client time in ms,
+// the droid replays them at the pace they were sent instead of the pace they arrive
+let neckStreamSeq = 0;
+let bodyStreamSeq = 0;
+
 function sendNeckUpdate() {
     if (JoyNeck) { 
         const data = {
+            seq: ++neckStreamSeq,
+            t: Math.round(performance.now()),
             automatic: false,
             neck: {
                 rotate: parseInt(JoyNeck.GetX()), 
@@ -106,6 +113,8 @@ function sendNeckUpdate() {
 function sendBodyUpdate() {
     if (JoyBody) { 
         const data = {
+            seq: ++bodyStreamSeq,
+            t: Math.round(performance.now()),
             automatic: false,
             body: {
                 rotate: parseInt(JoyBody.GetX()), 
@@ -1,11 +1,73 @@
 #include "HuyangBody.h"
-#include <Adafruit_PWMServoDriver.h>
 #include <Adafruit_NeoPixel.h>
-
-// Corrected typo: Adafruit_PWMServoDriver
-HuyangBody::HuyangBody(Adafruit_PWMServoDriver *pwm)
+#include "../HuyangGesture/HuyangGesture.h" // Directions of the gesture layers
+
+// Linkage of the body tilt servos, see ServoMixer.h. Both tilts use the -100 to 100 input.
+static const ServoMixer::Input HuyangBody_mixInputs[] = {
+	{HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT}, // 0: tilt forward
+	{HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT}  // 1: tilt sideways
+};
+
+static const ServoMixer::Servo HuyangBody_mixServos[] = {
+	{pwm_pin_sideway_left, ServoMixer_DEGREE(0), ServoMixer_DEGREE(180)},  // 0
+	{pwm_pin_sideway_right, ServoMixer_DEGREE(0), ServoMixer_DEGREE(180)}, // 1
+	{pwm_pin_forward_left, ServoMixer_DEGREE(0), ServoMixer_DEGREE(180)},  // 2
+	{pwm_pin_forward_right, ServoMixer_DEGREE(0), ServoMixer_DEGREE(180)}  // 3
+};
+
+// Sideways: the input covers -82 to 38 of the linkage (-60 to 60 shifted by -22) on 0-170 degrees,
+// the right servo sits 15 degrees further. Forward: 70-180 degrees (30-140 shifted by 40), the right
+// servo is mounted mirrored and turns the other way.
+static const ServoMixer::Link HuyangBody_mixLinks[] = {
+	{0, 1, ServoMixer_DEGREE(15.3), ServoMixer_DEGREE(117.3)},
+	{1, 1, ServoMixer_DEGREE(30.3), ServoMixer_DEGREE(132.3)},
+	{2, 0, ServoMixer_DEGREE(70), ServoMixer_DEGREE(180)},
+	{3, 0, ServoMixer_DEGREE(110), ServoMixer_DEGREE(0)}
+};
+
+HuyangBody::HuyangBody(PwmBus *bus, MotionAxis *motion)
 {
-	_pwm = pwm;
+	_bus = bus;
+	_motion = motion;
+
+	_mixer = new ServoMixer(bus);
+	_mixer->build(HuyangBody_mixInputs, 2, HuyangBody_mixServos, 4, HuyangBody_mixLinks, 4, HuyangBody_SERVOMIN, HuyangBody_SERVOMAX);
+
+	// Rotation drives one servo, the tilt axes are mixed into servo pairs in loop()
+	_axisRotate = _motion->addAxis(rotationToSubticks(0), pwm_pin_body_rotate);
+	_axisTiltForward = _motion->addAxis(0);
+	_axisTiltSideways = _motion->addAxis(0);
+
+	// Body axes follow the velocity and acceleration limited planner instead of timed easing
+	_motion->setLimits(_axisRotate, HuyangBody_ROTATE_MAX_VELOCITY, HuyangBody_ROTATE_MAX_ACCELERATION);
+	_motion->setLimits(_axisTiltForward, HuyangBody_TILT_MAX_VELOCITY, HuyangBody_TILT_MAX_ACCELERATION);
+	_motion->setLimits(_axisTiltSideways, HuyangBody_TILT_MAX_VELOCITY, HuyangBody_TILT_MAX_ACCELERATION);
+
+	// Idle and gesture motion is added on top of the manual position
+	_idleRotate = _motion->addLayer(_axisRotate, MotionAxis::Idle);
+	_idleTiltForward = _motion->addLayer(_axisTiltForward, MotionAxis::Idle);
+	_idleTiltSideways = _motion->addLayer(_axisTiltSideways, MotionAxis::Idle);
+	_gestureRotate = _motion->addLayer(_axisRotate, MotionAxis::Gesture);
+	_gestureTiltForward = _motion->addLayer(_axisTiltForward, MotionAxis::Gesture);
+	_gestureTiltSideways = _motion->addLayer(_axisTiltSideways, MotionAxis::Gesture);
+	_motion->setOutputRange(_axisRotate, rotationToSubticks(HuyangBody_MIN_INPUT), rotationToSubticks(HuyangBody_MAX_INPUT));
+	_motion->setOutputRange(_axisTiltForward, motionToQ8(HuyangBody_MIN_INPUT), motionToQ8(HuyangBody_MAX_INPUT));
+	_motion->setOutputRange(_axisTiltSideways, motionToQ8(HuyangBody_MIN_INPUT), motionToQ8(HuyangBody_MAX_INPUT));
+
+	// Servo model: the axis velocity at which the slowest of its servos turns at full speed, after the planner limits
+	int32_t degreesPerSecond = 60000 / HuyangBody_SERVO_SPEED;
+	int32_t inputRange = HuyangBody_MAX_INPUT - HuyangBody_MIN_INPUT;
+	_motion->setDynamics(_axisRotate, (rotationToSubticks(HuyangBody_MAX_INPUT) - rotationToSubticks(HuyangBody_MIN_INPUT)) * degreesPerSecond / 70, HuyangBody_SERVO_TIME_CONSTANT);
+	_motion->setDynamics(_axisTiltForward, motionToQ8(inputRange) * degreesPerSecond / 110, HuyangBody_SERVO_TIME_CONSTANT); // Forward servos turn 110 degrees
+	_motion->setDynamics(_axisTiltSideways, motionToQ8(inputRange) * degreesPerSecond / 102, HuyangBody_SERVO_TIME_CONSTANT); // Sideways servos turn 102 degrees
+
+	// The idle layers follow noise instead of random targets, the body breathes on its forward tilt
+	_idle = new MotionIdle(_motion, 128);
+	_idle->add(_idleRotate, rotationToSubticks(HuyangBody_IDLE_ROTATE) - rotationToSubticks(0), HuyangBody_IDLE_ROTATE_FREQUENCY);
+	_idle->add(_idleTiltForward, motionToQ8(HuyangBody_IDLE_TILT), HuyangBody_IDLE_TILT_FREQUENCY);
+	_idle->add(_idleTiltSideways, motionToQ8(HuyangBody_IDLE_TILT), HuyangBody_IDLE_TILT_FREQUENCY);
+	_idle->breathe(_idleTiltForward, motionToQ8(HuyangBody_IDLE_BREATH), HuyangBody_IDLE_BREATH_PERIOD);
+
 	// Initialize NeoPixel object for 2 pixels on NEO_PIXEL_PIN
 	// This pin MUST be defined in config.h or similar if it's not a fixed value.
 	_neoPixelLights = new Adafruit_NeoPixel(NEO_PIXEL_COUNT, NEO_PIXEL_PIN, pixelFormat);
@@ -21,82 +83,80 @@ void HuyangBody::setup()
 	updateChestLights(); // Set initial light mode
 }
 
-// Maps a degree value to a PWM pulselength and sends it to the specified servo pin
-void HuyangBody::rotateServo(uint8_t servo, uint16_t degree)
+// Converts a Q8 servo angle (0-180) to sub-ticks in the PCA9685 pulse length range
+int32_t HuyangBody::degreeToSubticks(int32_t degreeQ8)
 {
-	// Map the input degree (0-180 for standard servos) to the PCA9685 pulse length range
-	uint16_t pulselength = map(degree, 0, 180, HuyangBody_SERVOMIN, HuyangBody_SERVOMAX);
+	return motionDegreeQ8ToSubticks(degreeQ8, HuyangBody_SERVOMIN, HuyangBody_SERVOMAX);
+}
 
-	// Set the PWM output for the specified servo pin
-	_pwm->setPWM(servo, 0, pulselength);
+// Converts a body rotation input to sub-ticks, the hip servo uses 0-70 degrees
+int32_t HuyangBody::rotationToSubticks(int16_t degree)
+{
+	int32_t rotateDegree = motionMap(motionToQ8(degree), motionToQ8(HuyangBody_MIN_INPUT), motionToQ8(HuyangBody_MAX_INPUT), 0, motionToQ8(70));
+	return degreeToSubticks(rotateDegree);
 }
 
 // Main loop for HuyangBody, called repeatedly from system.h
 void HuyangBody::loop()
 {
-	_currentMillis = millis(); // Get current time
+	_currentMillis = _motion->now(); // Time of this control tick
 
-	// Reset previousMillis if system time rolls over
-	if (_previousMillis > _currentMillis)
-	{
-		_previousMillis = _currentMillis;
-	}
-
-	// If in automatic mode, trigger random movements
-	if (automatic == true)
-	{
-		doRandomRotate();
-		doRandomTiltForward();
-		doRandomTiltSideways();
-	}
+	// Mix the tilt axes of this tick into their servos
+	updateTilt();
 
 	updateChestLights(); // Continuously update chest lights based on current mode
 }
 
+void HuyangBody::tickIdle(unsigned long now)
+{
+	// How much of the idle motion is visible is set by the layer weight
+	_idle->tick(now);
+}
+
 // --- Body Movement Control Functions ---
 
 // Controls body sideways tilt
-void HuyangBody::tiltBodySideways(int16_t degree)
+void HuyangBody::tiltBodySideways(int16_t degree, uint16_t duration)
 {
-	// Apply calibration offset
-	degree += calibrationTiltSideways;
-
-	// These mapping values are highly specific to your robot's physical design and servo limits.
-	// `calibrationShift` is an existing offset in your original code.
-	int16_t calibrationShift = -22; // max 0 to -60
-	int16_t calibratedDegree = map(degree, -100, 100, -60 + calibrationShift, 60 + calibrationShift);
-	uint16_t rotateDegree = map(calibratedDegree, -100, 100, 0, 170);
+	degree = constrain(degree, HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT);
 
-	// Apply to left and right servos, potentially with small offsets for symmetry
-	rotateServo(pwm_pin_sideway_left, rotateDegree + 0);
-	rotateServo(pwm_pin_sideway_right, rotateDegree + 15); // Original code had +15
+	if (targetTiltSideways != degree) // Only update if target has changed
+	{
+		targetTiltSideways = degree;
+		_motion->moveTo(_axisTiltSideways, motionToQ8(degree), duration);
+	}
 }
 
 // Controls body forward/backward tilt
-void HuyangBody::tiltBodyForward(int16_t degree)
+void HuyangBody::tiltBodyForward(int16_t degree, uint16_t duration)
 {
-	// Apply calibration offset
-	degree += calibrationTiltForward;
-
-	// `calibrationShift` is an existing offset in your original code.
-	int16_t calibrationShift = 40; // max 0 to 40
-	uint16_t rotateDegree = map(degree, -100, 100, 30 + calibrationShift, 140 + calibrationShift);
+	degree = constrain(degree, HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT);
 
-	// Apply to left and right servos, note the 180 - rotateDegree for right servo for opposing motion
-	rotateServo(pwm_pin_forward_left, rotateDegree);
-	rotateServo(pwm_pin_forward_right, 180 - rotateDegree);
+	if (targetTiltForward != degree) // Only update if target has changed
+	{
+		targetTiltForward = degree;
+		_motion->moveTo(_axisTiltForward, motionToQ8(degree), duration);
+	}
 }
 
 // Controls body rotation (hip/torso rotation)
-void HuyangBody::rotateBody(int16_t degree)
+void HuyangBody::rotateBody(int16_t degree, uint16_t duration)
 {
-	// Apply calibration offset
-	degree += calibrationRotate;
+	degree = constrain(degree, HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT);
+
+	if (targetRotate != degree) // Only update if target has changed
+	{
+		targetRotate = degree;
+		_motion->moveTo(_axisRotate, rotationToSubticks(degree), duration);
+	}
+}
 
-	// `calibrationShift` is an existing offset in your original code.
-	int16_t calibrationShift = 0; // max 0 to 20
-	uint16_t rotateDegree = map(degree, -100, 100, 0 + calibrationShift, 70 + calibrationShift);
-	rotateServo(pwm_pin_body_rotate, rotateDegree);
+// Mixes the current forward and sideways tilt into the four tilt servos
+void HuyangBody::updateTilt(uint8_t servoMask)
+{
+	// Same order as HuyangBody_mixInputs, the bus only sends the servos that changed
+	int32_t inputs[] = {_motion->output(_axisTiltForward), _motion->output(_axisTiltSideways)};
+	_mixer->update(inputs, servoMask);
 }
 
 // Sets all body servos to their predefined center positions
@@ -104,78 +164,53 @@ void HuyangBody::centerAll()
 {
 	// These values (0) should ideally correspond to the mechanical center
 	// before any calibration offsets are applied.
-	tiltBodySideways(0);
+	targetTiltSideways = 0;
+	targetTiltForward = 0;
+	targetRotate = 0;
+	_motion->setPosition(_axisTiltSideways, 0);
+	_motion->setPosition(_axisTiltForward, 0);
+	_motion->setPosition(_axisRotate, rotationToSubticks(0));
+
+	// Each group is flushed on its own so the servos power up one after another
+	updateTilt(0b0011); // Sideways pair
+	_bus->flushAll();
 	delay(500); // Small delay to allow servos to reach position
-	tiltBodyForward(0);
+	updateTilt(0b1100); // Forward pair
+	_bus->flushAll();
 	delay(500);
-	rotateBody(0);
+	_bus->setServo(pwm_pin_body_rotate, rotationToSubticks(0));
+	_bus->flushAll();
 }
 
-// --- Random Movement Functions (for automatic mode) ---
+// --- Gesture Layer ---
 
-void HuyangBody::doRandomRotate()
+uint8_t HuyangBody::gestureAxis(uint8_t direction)
 {
-	if (_randomDoRotate == 0)
-	{
-		_randomDoRotate = _currentMillis + 2000 + (random(6, 12 + 1) * 1000);
-	}
-
-	if (_currentMillis > _randomDoRotate)
-	{
-		_randomDoRotate = 0;
-
-		if (random(0, 2) == 0) // Randomly choose direction
-		{
-			rotateBody(-(random(10, 80 + 1))); // Rotate left
-		}
-		else
-		{
-			rotateBody(random(10, 80 + 1)); // Rotate right
-		}
-	}
+	const uint8_t axes[] = {_gestureRotate, _gestureTiltForward, _gestureTiltSideways};
+	return axes[direction];
 }
 
-void HuyangBody::doRandomTiltForward()
+// Same scaling as rotateBody() and the tilt functions, without the offset of the neutral position
+int32_t HuyangBody::gestureOffset(uint8_t direction, int16_t input)
 {
-	if (_randomDoTiltForward == 0)
-	{
-		_randomDoTiltForward = _currentMillis + 2500 + (random(6, 12 + 1) * 1050);
-	}
-
-	if (_currentMillis > _randomDoTiltForward)
+	if (direction == HuyangGesture_ROTATE)
 	{
-		_randomDoTiltForward = 0;
-
-		if (random(0, 2) == 0) // Randomly choose direction
-		{
-			tiltBodyForward(-(random(10, 80 + 1))); // Tilt forward
-		}
-		else
-		{
-			tiltBodyForward(random(10, 80 + 1)); // Tilt backward
-		}
+		return rotationToSubticks(input) - rotationToSubticks(0);
 	}
+	return motionToQ8(input);
 }
 
-void HuyangBody::doRandomTiltSideways()
+// Inverse of the scaling in rotateBody() and the tilt functions
+int16_t HuyangBody::estimate(uint8_t direction)
 {
-	if (_randomDoTiltSideways == 0)
-	{
-		_randomDoTiltSideways = _currentMillis + 3000 + (random(5, 10 + 1) * 1100);
-	}
-
-	if (_currentMillis > _randomDoTiltSideways)
+	switch (direction)
 	{
-		_randomDoTiltSideways = 0;
-
-		if (random(0, 2) == 0) // Randomly choose direction
-		{
-			tiltBodySideways(-(random(10, 80 + 1))); // Tilt left
-		}
-		else
-		{
-			tiltBodySideways(random(10, 80 + 1)); // Tilt right
-		}
+	case HuyangGesture_ROTATE:
+		return motionMap(_motion->estimate(_axisRotate), rotationToSubticks(HuyangBody_MIN_INPUT), rotationToSubticks(HuyangBody_MAX_INPUT), HuyangBody_MIN_INPUT, HuyangBody_MAX_INPUT);
+	case HuyangGesture_TILT_FORWARD:
+		return motionFromQ8(_motion->estimate(_axisTiltForward));
+	default:
+		return motionFromQ8(_motion->estimate(_axisTiltSideways));
 	}
 }
 
@@ -2,7 +2,10 @@
 #define HuyangBody_h
 
 #include "Arduino.h"
-#include <Adafruit_PWMServoDriver.h> // For servo motor control
+#include "../PwmBus/PwmBus.h"      // Shared servo outputs of all PCA9685 boards
+#include "../MotionAxis/MotionAxis.h" // Shared axis table that eases all movements
+#include "../ServoMixer/ServoMixer.h" // Lookup tables from the tilt axes to the four tilt servos
+#include "../MotionIdle/MotionIdle.h"  // Noise and breathing of the idle layer
 #include <Adafruit_NeoPixel.h>       // For NeoPixel (chest lights) control
 
 // Servo Parameters for PCA9685 PWM Driver
@@ -10,6 +13,34 @@
 #define HuyangBody_SERVOMAX 595	 // This is the 'maximum' pulse length count (out of 4096)
 #define HuyangBody_SERVO_FREQ 60 // Analog servos typically run at ~50 Hz updates
 
+// Motion limits of the body axes, the heavy torso should never be jerked around.
+// Rotation in servo sub-ticks (see MotionMath.h, ~40 sub-ticks per degree), tilts in Q8 input units (-100 to 100 << 8).
+#define HuyangBody_ROTATE_MAX_VELOCITY 2400      // ~60 degree per second
+#define HuyangBody_ROTATE_MAX_ACCELERATION 4800
+#define HuyangBody_TILT_MAX_VELOCITY 40000       // ~150 input units per second
+#define HuyangBody_TILT_MAX_ACCELERATION 80000
+
+// Entries the body takes in the MotionAxis table: rotation and both tilts, each with an idle and a gesture layer
+#define HuyangBody_AXES 9
+
+// Servo model for the estimated pose (see MotionAxis::setDynamics()): data sheet speed in ms per 60 degrees
+// of the 60 and 80 kg servos, and the time constant in ms of their control loop
+#define HuyangBody_SERVO_SPEED 200
+#define HuyangBody_SERVO_TIME_CONSTANT 80
+
+// Idle motion: how far each axis wanders (input units) and how often it turns (Q8 Hz), the torso moves slower than the head
+#define HuyangBody_IDLE_ROTATE 45
+#define HuyangBody_IDLE_ROTATE_FREQUENCY 20 // ~0.08 Hz
+#define HuyangBody_IDLE_TILT 30
+#define HuyangBody_IDLE_TILT_FREQUENCY 26
+// Breathing on the forward tilt: depth in input units and ms per breath
+#define HuyangBody_IDLE_BREATH 5
+#define HuyangBody_IDLE_BREATH_PERIOD 4500
+
+// Input range of all body axes
+#define HuyangBody_MIN_INPUT -100
+#define HuyangBody_MAX_INPUT 100
+
 // PWM channel pins for body servos on the PCA9685 board
 #define pwm_pin_sideway_left (uint8_t)14  // Left body sideways tilt servo
 #define pwm_pin_sideway_right (uint8_t)15 // Right body sideways tilt servo
@@ -25,30 +56,37 @@
 class HuyangBody
 {
 public:
-	// Constructor: takes a pointer to the PWM driver
-	HuyangBody(Adafruit_PWMServoDriver *pwm);
+	// Constructor: takes the shared PWM bus and the axis table the body registers its axes in
+	HuyangBody(PwmBus *bus, MotionAxis *motion);
 
 	// Setup function: initializes NeoPixels and performs initial servo centering
 	void setup();
-	// Loop function: called repeatedly to update servo positions and handle light animations
+	// Loop function: called once per control tick after MotionAxis::tick() to update servo positions and light animations
 	void loop();
-
-	// Flag to enable/disable automatic animations
-	bool automatic = true;
+	// Writes the idle layer offsets for the given time, call once per control tick before MotionAxis::tick()
+	void tickIdle(unsigned long now);
 
 	// Public control functions for body movements
-	void tiltBodySideways(int16_t degree);
-	void tiltBodyForward(int16_t degree);
-	void rotateBody(int16_t degree);
+	void tiltBodySideways(int16_t degree, uint16_t duration = 1000);
+	void tiltBodyForward(int16_t degree, uint16_t duration = 1000);
+	void rotateBody(int16_t degree, uint16_t duration = 1000);
+
+	// Target values (-100 to 100) including calibration
+	int16_t targetTiltSideways = 0;
+	int16_t targetTiltForward = 0;
+	int16_t targetRotate = 0;
 
 	// Sets all body servos to their center positions
 	void centerAll();
 
-	// --- NEW: Calibration offsets ---
-	// These values will be added/subtracted to the target degrees
-	int16_t calibrationRotate = 0;
-	int16_t calibrationTiltForward = 0;
-	int16_t calibrationTiltSideways = 0;
+	// Gesture layer of a direction (HuyangGesture_ROTATE, _TILT_FORWARD, _TILT_SIDEWAYS), driven by HuyangGesture
+	uint8_t gestureAxis(uint8_t direction);
+	// Offset of an input value (-100 to 100 scale) in the units of that gesture layer
+	int32_t gestureOffset(uint8_t direction, int16_t input);
+
+	// Where the servos of a direction (HuyangGesture_ROTATE, ...) really are, estimated from their speed.
+	// Input scale (-100 to 100), including idle and gesture motion.
+	int16_t estimate(uint8_t direction);
 
 	// --- NEW: Chest Light Control ---
 	enum LightMode
@@ -61,32 +99,41 @@ public:
 	void updateChestLights(); // Function to manage chest light behavior
 
 private:
-	Adafruit_PWMServoDriver *_pwm;      // Pointer to the PWM driver instance
+	PwmBus *_bus;                       // Shared PWM bus, flushed once per loop in system.h
+	MotionAxis *_motion;                // Shared axis table, ticked once per loop in system.h
+	ServoMixer *_mixer;                 // Tilt forward and sideways into their servo pairs
 	Adafruit_NeoPixel *_neoPixelLights; // Pointer to the NeoPixel object
 
-	unsigned long _currentMillis = 0;   // Current time in milliseconds
-	unsigned long _previousMillis = 0;  // Previous time for general timing
-
-	// Timers for automatic body movements
-	unsigned long _randomDoRotate = 0;
-	unsigned long _randomDoTiltForward = 0;
-	unsigned long _randomDoTiltSideways = 0;
+	unsigned long _currentMillis = 0;   // Time of the current control tick in milliseconds
 
 	// Timers for chest light animations
 	unsigned long _lastLightToggleMillis = 0;
 	uint16_t _blinkInterval = 500; // Milliseconds for blink interval
 
-	// Private helper methods
-	// Maps a degree value to a PWM pulselength and sends it to the specified servo pin
-	void rotateServo(uint8_t servo, uint16_t degree);
+	// Axes in the shared MotionAxis table.
+	// Tilt axes hold the Q8 input (-100 to 100) and are mixed into two servos each,
+	// rotation is kept in servo sub-ticks and written by the table itself.
+	uint8_t _axisRotate;
+	uint8_t _axisTiltForward;
+	uint8_t _axisTiltSideways;
+
+	// Offsets of the idle and gesture layers, same units as their base axis
+	uint8_t _idleRotate;
+	uint8_t _idleTiltForward;
+	uint8_t _idleTiltSideways;
+	uint8_t _gestureRotate;
+	uint8_t _gestureTiltForward;
+	uint8_t _gestureTiltSideways;
+	MotionIdle *_idle; // Drives the idle layers
 
-	// Internal update functions for easing (if applicable, current body movements are direct)
-	// Add similar easing variables and functions here if smoothing is desired for body movements.
+	// Private helper methods
+	// Converts a Q8 servo angle (0-180) to sub-ticks
+	int32_t degreeToSubticks(int32_t degreeQ8);
+	// Converts a body rotation input (-100 to 100) to sub-ticks of the rotation servo
+	int32_t rotationToSubticks(int16_t degree);
 
-	// Functions for generating random movements
-	void doRandomRotate();
-	void doRandomTiltForward();
-	void doRandomTiltSideways();
+	// Mix the eased tilt axes into their servo pairs, servoMask selects servos of HuyangBody_mixServos
+	void updateTilt(uint8_t servoMask = 0xFF);
 
 	// Internal light control functions
 	void setAllLights(uint32_t color);
@@ -69,6 +69,21 @@ HuyangFace::HuyangFace(Arduino_GFX *left, Arduino_GFX *right)
 {
 	_leftEye = left;
 	_rightEye = right;
+
+	// setup() fills both panels with the eye colour, no row has a lid
+	memset(_lidStart, 0, sizeof(_lidStart));
+	memset(_lidEnd, 0, sizeof(_lidEnd));
+}
+
+bool HuyangFace::isDrawing()
+{
+	return _drawStep < _drawSteps;
+}
+
+void HuyangFace::resetCounters()
+{
+	spiBytes = 0;
+	drawnSpans = 0;
 }
 
 void HuyangFace::setup()
@@ -94,14 +109,22 @@ void HuyangFace::loop()
 		_previousMillis = _currentMillis;
 	}
 
-	closeEyesLoop(); // Original call
-
-	if (_currentMillis - _previousMillis > 100) // Original condition
+	if (isDrawing())
+	{
+		// A mood is still being drawn, continue it for one frame and start nothing new
+		drawFrame();
+	}
+	else
 	{
-		openEyesLoop(); // Original call
-		focusEyesLoop(); // Original call
-		sadEyesLoop(); // Original call
-		angryEyesLoop(); // Original call
+		closeEyesLoop(); // Original call
+
+		if (_currentMillis - _previousMillis > 100) // Original condition
+		{
+			openEyesLoop(); // Original call
+			focusEyesLoop(); // Original call
+			sadEyesLoop(); // Original call
+			angryEyesLoop(); // Original call
+		}
 	}
 
 	if (automatic == true && _currentMillis > _previousRandomMillis + _randomDuration)
@@ -6,6 +6,13 @@
 
 #define tftColor(r, g, b) ((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3))
 
+// Time in microseconds one loop() may spend drawing, the rest of the mood follows in the next loops
+#define HuyangFace_DRAW_BUDGET 2000
+// Panel height, the lid spans keep one entry per row
+#define HuyangFace_ROWS 240
+// Bytes a GC9A01 line costs on SPI besides its pixels: column and row address window and the write command
+#define HuyangFace_SPI_OVERHEAD 11
+
 class HuyangFace
 {
 public:
@@ -34,6 +41,14 @@ public:
 	// Moved to public as per original implementation logic from HuyangFace.cpp
 	EyeState getStateFrom(uint8_t state); 
 
+	// true while a mood is drawn, loop() then only continues the drawing
+	bool isDrawing();
+
+	// Drawing counters since the last resetCounters(), like the traffic counters of PwmBus
+	uint32_t spiBytes = 0;   // Pixels and command bytes sent to both panels
+	uint32_t drawnSpans = 0; // Lines sent
+	void resetCounters();
+
 private:
 	Arduino_GFX *_leftEye;
 	Arduino_GFX *_rightEye;
@@ -59,29 +74,63 @@ private:
 	EyeState _rightEyeState = Closed; // Original state tracking
 	
 	uint32_t _randomDuration = 2000;
-	uint16_t _blinkDelay = 1;
-
-	// Original drawing loop functions declared here
+	uint16_t _blinkDelay = 1; // ms per drawing step
+
+	// Mood being drawn. The draw functions below only start it, drawFrame() draws as many steps per loop()
+	// as are due at one step per _blinkDelay, within HuyangFace_DRAW_BUDGET, so servos and web keep running.
+	//
+	// Every mood is a lid over the eye colour, described as one span of lid pixels per row. The panel keeps the
+	// spans it shows. A mood first erases the lid it does not have on all rows at once, as the fillScreen() of the
+	// original moods did, then its steps only send the ends of a row that differ, so similar moods cost a few short
+	// lines and the lid that stays is never redrawn.
+	enum DrawShape
+	{
+		DrawOpen = 0,  // No lid, rows from the middle to top and bottom
+		DrawClose = 1, // Full lid, rows from top and bottom to the middle
+		DrawFocus = 2, // Lid over the outer two thirds of each half, rows like DrawClose
+		DrawSlant = 3  // Lid over the lower half that gets shorter to the middle, sad and angry eyes, rows from the bottom up
+	};
+	DrawShape _drawShape = DrawOpen;
+	Arduino_GFX *_drawEye[2] = {nullptr, nullptr}; // Left and right panel, nullptr = not drawn
+	bool _drawInner[2] = {false, false};           // DrawSlant: the lid starts at the inner edge
+	uint16_t _drawColor = 0;                       // Lid colour
+	uint16_t _drawClearRow = 0; // Rows erased, the steps start once all are
+	uint16_t _drawStep = 0;
+	uint16_t _drawSteps = 0;
+
+	// Lid span shown on each row of the left and right panel, start == end for no lid
+	uint8_t _lidStart[2][HuyangFace_ROWS];
+	uint8_t _lidEnd[2][HuyangFace_ROWS];
+
+	void startDrawing(DrawShape shape, Arduino_GFX *left, bool leftInner, Arduino_GFX *right, bool rightInner, uint16_t color);
+	void drawFrame();
+	void drawStep(uint8_t panel, uint16_t step);
+	void lidSpan(uint8_t panel, uint16_t row, uint16_t &start, uint16_t &end);
+	void clearRow(uint8_t panel, uint16_t row);
+	void drawRow(uint8_t panel, uint16_t row);
+	void drawSpan(Arduino_GFX *eye, uint16_t row, uint16_t start, uint16_t end, uint16_t color);
+
+	// Mood functions. The *Loop() ones pick the eyes that change to their mood, the others only start its drawing
+	// with startDrawing(): a clear phase that erases the lid the mood does not have, then the steps that send the
+	// span ends that differ from what the panel shows.
 	void openEyesLoop();
-	void openEyes(uint16_t color); // This function will now clear the screen first
-	void openEye(Arduino_GFX *eye, uint16_t color); // This function will now clear the screen first
+	void openEyes(uint16_t color);
+	void openEye(Arduino_GFX *eye, uint16_t color);
 
 	void closeEyesLoop();
 	void closeEyes(uint16_t color);
 	void closeEye(Arduino_GFX *eye, uint16_t color);
 
 	void focusEyesLoop();
-	void focusEyes(uint16_t color); // This function will now clear the screen first
-	void focusEye(Arduino_GFX *eye, uint16_t color); // This function will now clear the screen first
+	void focusEyes(uint16_t color);
+	void focusEye(Arduino_GFX *eye, uint16_t color);
 
 	void sadEyesLoop();
-	void sadEyes(uint16_t color); // This function will now clear the screen first
-	void sadEye(Arduino_GFX *eye, bool inner, uint16_t color); // This function will now clear the screen first
+	void sadEyes(uint16_t color);
+	void sadEye(Arduino_GFX *eye, bool inner, uint16_t color); // inner: the lid starts at the inner edge
 
 	void angryEyesLoop();
-	void angryEyes(uint16_t color); // This function will now clear the screen first
-	// Note: angryEye helper was not in original HuyangFace.h, so not re-adding.
-	// If it exists in _moods.cpp, it should also clear if called directly.
+	void angryEyes(uint16_t color);
 };
 
 #endif
@@ -39,46 +39,13 @@ void HuyangFace::openEyesLoop()
 void HuyangFace::openEyes(uint16_t color)
 {
 	Serial.println("openEyes");
-    // Clear both screens before drawing new mood
-    _leftEye->fillScreen(_huyangEyeColor);
-    _rightEye->fillScreen(_huyangEyeColor);
-
-	for (uint16_t step = 0; step <= _tftDisplayHeight / 2; step++)
-	{
-		uint16_t position = (_tftDisplayHeight / 2) - step;
-
-		_leftEye->drawFastHLine(0, position, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, position, _tftDisplayWidth, color);
-		_leftEye->drawFastHLine(0, _tftDisplayHeight - position, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, _tftDisplayHeight - position, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawOpen, _leftEye, false, _rightEye, false, color);
 }
 
 void HuyangFace::openEye(Arduino_GFX *eye, uint16_t color)
 {
 	Serial.println("openEye");
-    // Clear individual screen before drawing new mood
-    eye->fillScreen(_huyangEyeColor);
-
-	for (uint16_t step = 0; step <= _tftDisplayHeight / 2; step++)
-	{
-		uint16_t position = (_tftDisplayHeight / 2) - step;
-
-		eye->drawFastHLine(0, position, _tftDisplayWidth, color);
-		eye->drawFastHLine(0, _tftDisplayHeight - position, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawOpen, eye == _leftEye ? eye : nullptr, false, eye == _rightEye ? eye : nullptr, false, color);
 }
 
 void HuyangFace::closeEyesLoop()
@@ -112,41 +79,13 @@ void HuyangFace::closeEyesLoop()
 void HuyangFace::closeEyes(uint16_t color)
 {
 	Serial.println("closeEyes");
-    // Original behavior for closeEyes seems to draw over the whole screen,
-    // which implicitly clears. No additional fillScreen needed here to preserve original.
-
-	for (uint16_t step = 0; step <= _tftDisplayHeight / 2; step++)
-	{
-
-		_leftEye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		_leftEye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawClose, _leftEye, false, _rightEye, false, color);
 }
 
 void HuyangFace::closeEye(Arduino_GFX *eye, uint16_t color)
 {
 	Serial.println("closeEye");
-    // Original behavior for closeEye seems to draw over the whole screen,
-    // which implicitly clears. No additional fillScreen needed here to preserve original.
-	for (uint16_t step = 0; step <= _tftDisplayHeight / 2; step++)
-	{
-		eye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		eye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawClose, eye == _leftEye ? eye : nullptr, false, eye == _rightEye ? eye : nullptr, false, color);
 }
 
 void HuyangFace::focusEyesLoop()
@@ -179,42 +118,12 @@ void HuyangFace::focusEyesLoop()
 void HuyangFace::focusEyes(uint16_t color)
 {
 	Serial.println("focusEyes");
-    // Clear both screens before drawing new mood
-    _leftEye->fillScreen(_huyangEyeColor);
-    _rightEye->fillScreen(_huyangEyeColor);
-
-	for (uint16_t step = 0; step <= ((_tftDisplayHeight / 2) / 6 * 4); step++)
-	{
-
-		_leftEye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		_leftEye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-		_rightEye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawFocus, _leftEye, false, _rightEye, false, color);
 }
 void HuyangFace::focusEye(Arduino_GFX *eye, uint16_t color)
 {
 	Serial.println("focusEye");
-    // Clear individual screen before drawing new mood
-    eye->fillScreen(_huyangEyeColor);
-
-	for (uint16_t step = 0; step <= ((_tftDisplayHeight / 2) / 6 * 4); step++)
-	{
-		eye->drawFastHLine(0, step, _tftDisplayWidth, color);
-		eye->drawFastHLine(0, _tftDisplayHeight - step, _tftDisplayWidth, color);
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawFocus, eye == _leftEye ? eye : nullptr, false, eye == _rightEye ? eye : nullptr, false, color);
 }
 
 void HuyangFace::sadEyesLoop()
@@ -247,52 +156,12 @@ void HuyangFace::sadEyesLoop()
 void HuyangFace::sadEyes(uint16_t color)
 {
 	Serial.println("sadEyes");
-    // Clear both screens before drawing new mood
-    _leftEye->fillScreen(_huyangEyeColor);
-    _rightEye->fillScreen(_huyangEyeColor);
-
-	uint16_t length = _tftDisplayHeight;
-
-	for (uint16_t step = 0; step <= _tftDisplayHeight; step++)
-	{
-		_leftEye->drawFastHLine(_tftDisplayHeight - length, _tftDisplayHeight - step, length, color);
-		_rightEye->drawFastHLine(0, _tftDisplayHeight - step, length, color);
-		length = length - 2;
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawSlant, _leftEye, true, _rightEye, false, color);
 }
 void HuyangFace::sadEye(Arduino_GFX *eye, bool inner, uint16_t color)
 {
 	Serial.println("sadEye");
-    // Clear individual screen before drawing new mood
-    eye->fillScreen(_huyangEyeColor);
-
-	uint16_t length = _tftDisplayHeight;
-	uint16_t left = 0;
-
-	for (uint16_t step = 0; step <= _tftDisplayHeight; step++)
-	{
-
-		if (inner == true)
-		{
-			left = _tftDisplayHeight - length;
-		}
-
-		eye->drawFastHLine(left, _tftDisplayHeight - step, length, color);
-
-		length = length - 2;
-
-		while (_currentMillis - _previousMillis < _blinkDelay)
-		{
-			_currentMillis = millis();
-		}
-		_previousMillis = _currentMillis;
-	}
+	startDrawing(DrawSlant, eye == _leftEye ? eye : nullptr, inner, eye == _rightEye ? eye : nullptr, inner, color);
 }
 
 void HuyangFace::angryEyesLoop()
@@ -324,22 +193,209 @@ void HuyangFace::angryEyesLoop()
 void HuyangFace::angryEyes(uint16_t color)
 {
 	Serial.println("angryEyes");
-    // Clear both screens before drawing new mood
-    _leftEye->fillScreen(_huyangEyeColor);
-    _rightEye->fillScreen(_huyangEyeColor);
+	startDrawing(DrawSlant, _leftEye, false, _rightEye, true, color);
+}
 
-	uint16_t length = _tftDisplayHeight;
+// --- Frame-stepped drawing ---
 
-	for (uint16_t step = 0; step <= _tftDisplayHeight; step++)
+void HuyangFace::startDrawing(DrawShape shape, Arduino_GFX *left, bool leftInner, Arduino_GFX *right, bool rightInner, uint16_t color)
+{
+	_drawShape = shape;
+	_drawEye[0] = left;
+	_drawEye[1] = right;
+	_drawInner[0] = leftInner;
+	_drawInner[1] = rightInner;
+	_drawColor = color;
+	_drawStep = 0;
+	_drawClearRow = 0;
+	_previousMillis = _currentMillis; // Nothing else starts in this loop() either
+
+	switch (shape)
 	{
-		_leftEye->drawFastHLine(0, _tftDisplayHeight - step, length, color);
-		_rightEye->drawFastHLine(_tftDisplayHeight - length, _tftDisplayHeight - step, length, color);
-		length = length - 2;
+	case DrawFocus:
+		_drawSteps = (_tftDisplayHeight / 2) / 6 * 4 + 1;
+		break;
+	case DrawSlant:
+		_drawSteps = _tftDisplayHeight + 1;
+		break;
+	default:
+		_drawSteps = _tftDisplayHeight / 2 + 1;
+		break;
+	}
+}
 
-		while (_currentMillis - _previousMillis < _blinkDelay)
+void HuyangFace::drawFrame()
+{
+	unsigned long start = micros();
+
+	// Lid the new mood does not have goes first and at once, like the fillScreen() the moods started with
+	while (_drawClearRow < _tftDisplayHeight && micros() - start < HuyangFace_DRAW_BUDGET)
+	{
+		for (uint8_t panel = 0; panel < 2; panel++)
 		{
-			_currentMillis = millis();
+			if (_drawEye[panel] != nullptr)
+			{
+				clearRow(panel, _drawClearRow);
+			}
 		}
+		_drawClearRow++;
 		_previousMillis = _currentMillis;
 	}
+
+	// Then the steps that are due since the last one, one per _blinkDelay ms like the original animation
+	while (_drawClearRow >= _tftDisplayHeight && isDrawing() &&
+		   _currentMillis - _previousMillis >= _blinkDelay && micros() - start < HuyangFace_DRAW_BUDGET)
+	{
+		for (uint8_t panel = 0; panel < 2; panel++)
+		{
+			if (_drawEye[panel] != nullptr)
+			{
+				drawStep(panel, _drawStep);
+			}
+		}
+		_drawStep++;
+		_previousMillis += _blinkDelay;
+	}
+
+	if (isDrawing() == false)
+	{
+		_previousMillis = _currentMillis; // The mood timing in loop() counts from the end of the drawing
+	}
+}
+
+// Rows of one step, in the order the original animation drew its lines
+void HuyangFace::drawStep(uint8_t panel, uint16_t step)
+{
+	switch (_drawShape)
+	{
+	case DrawOpen:
+		drawRow(panel, (_tftDisplayHeight / 2) - step);
+		drawRow(panel, (_tftDisplayHeight / 2) + step);
+		break;
+	case DrawClose:
+	case DrawFocus:
+		drawRow(panel, step);
+		drawRow(panel, _tftDisplayHeight - step);
+		break;
+	case DrawSlant:
+		drawRow(panel, _tftDisplayHeight - step);
+		break;
+	}
+}
+
+// Lid span of the mood being drawn on one row, start == end for no lid
+void HuyangFace::lidSpan(uint8_t panel, uint16_t row, uint16_t &start, uint16_t &end)
+{
+	start = 0;
+	end = 0;
+	switch (_drawShape)
+	{
+	case DrawClose:
+		end = _tftDisplayWidth;
+		break;
+	case DrawFocus:
+		if (row <= (_tftDisplayHeight / 2) / 6 * 4 || row >= _tftDisplayHeight - (_tftDisplayHeight / 2) / 6 * 4)
+		{
+			end = _tftDisplayWidth;
+		}
+		break;
+	case DrawSlant:
+		// Two pixels shorter per row up to the middle, the upper half stays open
+		if (row > _tftDisplayHeight / 2)
+		{
+			uint16_t length = 2 * row - _tftDisplayHeight;
+			start = _drawInner[panel] ? _tftDisplayWidth - length : 0;
+			end = start + length;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// Erases the part of the shown lid that is not in the mood, so only lid is left to draw
+void HuyangFace::clearRow(uint8_t panel, uint16_t row)
+{
+	uint16_t start;
+	uint16_t end;
+	lidSpan(panel, row, start, end);
+
+	Arduino_GFX *eye = _drawEye[panel];
+	uint16_t shownStart = _lidStart[panel][row];
+	uint16_t shownEnd = _lidEnd[panel][row];
+
+	if (start == end || end <= shownStart || shownEnd <= start)
+	{
+		drawSpan(eye, row, shownStart, shownEnd, _huyangEyeColor);
+		shownStart = shownEnd = 0;
+	}
+	else
+	{
+		drawSpan(eye, row, shownStart, start, _huyangEyeColor);
+		drawSpan(eye, row, end, shownEnd, _huyangEyeColor);
+		shownStart = max(shownStart, start);
+		shownEnd = min(shownEnd, end);
+	}
+
+	_lidStart[panel][row] = shownStart;
+	_lidEnd[panel][row] = shownEnd;
+}
+
+// Brings one row from its shown lid span to the span of the mood, only the pixels that change are sent
+void HuyangFace::drawRow(uint8_t panel, uint16_t row)
+{
+	if (row >= HuyangFace_ROWS)
+	{
+		return;
+	}
+
+	uint16_t start;
+	uint16_t end;
+	lidSpan(panel, row, start, end);
+
+	Arduino_GFX *eye = _drawEye[panel];
+	uint16_t shownStart = _lidStart[panel][row];
+	uint16_t shownEnd = _lidEnd[panel][row];
+
+	if (shownStart == shownEnd || start == end || end <= shownStart || shownEnd <= start)
+	{
+		// No overlap: the old lid goes, the new one comes
+		drawSpan(eye, row, shownStart, shownEnd, _huyangEyeColor);
+		drawSpan(eye, row, start, end, _drawColor);
+	}
+	else
+	{
+		// Overlapping lids only differ at their ends
+		if (start < shownStart)
+		{
+			drawSpan(eye, row, start, shownStart, _drawColor);
+		}
+		else
+		{
+			drawSpan(eye, row, shownStart, start, _huyangEyeColor);
+		}
+		if (end > shownEnd)
+		{
+			drawSpan(eye, row, shownEnd, end, _drawColor);
+		}
+		else
+		{
+			drawSpan(eye, row, end, shownEnd, _huyangEyeColor);
+		}
+	}
+
+	_lidStart[panel][row] = start;
+	_lidEnd[panel][row] = end;
+}
+
+void HuyangFace::drawSpan(Arduino_GFX *eye, uint16_t row, uint16_t start, uint16_t end, uint16_t color)
+{
+	if (start >= end)
+	{
+		return;
+	}
+
+	eye->drawFastHLine(start, row, end - start, color);
+	spiBytes += HuyangFace_SPI_OVERHEAD + 2 * (end - start);
+	drawnSpans++;
 }
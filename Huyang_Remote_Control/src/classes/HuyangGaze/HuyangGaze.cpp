@@ -0,0 +1,102 @@
+#include "HuyangGaze.h"
+
+// atan(i / 32) in Q8 degrees for i = 0..32
+static const uint16_t HuyangGaze_atanTable[33] PROGMEM = {
+	0, 458, 916, 1371, 1824, 2273, 2719, 3159, 3593, 4021, 4443, 4856, 5262, 5660, 6049, 6429, 6801,
+	7163, 7516, 7859, 8193, 8518, 8834, 9141, 9439, 9728, 10008, 10280, 10544, 10799, 11047, 11287, 11520};
+
+HuyangGaze::HuyangGaze(HuyangNeck *neck, HuyangBody *body)
+{
+	_neck = neck;
+	_body = body;
+}
+
+void HuyangGaze::lookAt(int16_t x, int16_t y, int16_t z)
+{
+	if (x != _x || z != _z)
+	{
+		_horizontal = motionSqrt((uint64_t)((int32_t)x * x) + (uint64_t)((int32_t)z * z));
+	}
+	_x = x;
+	_y = y;
+	_z = z;
+}
+
+void HuyangGaze::setCalibration(int16_t headRotate, int16_t neckTiltForward, int16_t bodyRotate)
+{
+	_calHeadRotate = headRotate;
+	_calNeckTiltForward = neckTiltForward;
+	_calBodyRotate = bodyRotate;
+}
+
+void HuyangGaze::loop()
+{
+	// Direction of the point: yaw around the vertical axis, pitch above the horizontal plane
+	int32_t yaw = atan2Q8(_x, _z);
+	int32_t pitch = atan2Q8(_y, _horizontal);
+
+	// Head rotation takes as much of the yaw as its range allows
+	int32_t headMin = motionToQ8(HuyangGaze_HEAD_YAW) * _neck->minRotation() / 100;
+	int32_t headMax = motionToQ8(HuyangGaze_HEAD_YAW) * _neck->maxRotation() / 100;
+	int32_t headYaw = constrain(yaw, headMin, headMax);
+
+	// The body turns for the rest, as far as it can
+	int32_t bodyMin = motionToQ8(HuyangGaze_BODY_YAW) * HuyangBody_MIN_INPUT / 100;
+	int32_t bodyMax = motionToQ8(HuyangGaze_BODY_YAW) * HuyangBody_MAX_INPUT / 100;
+	int32_t bodyYaw = constrain(yaw - headYaw, bodyMin, bodyMax);
+
+	headRotate = motionFromQ8(headYaw * 100 / HuyangGaze_HEAD_YAW);
+	bodyRotate = motionFromQ8(bodyYaw * 100 / HuyangGaze_BODY_YAW);
+
+	// Looking up tilts the neck back, so the forward tilt input has the opposite sign
+	int32_t tilt = motionFromQ8(-pitch * 100 / HuyangGaze_NECK_PITCH);
+	neckTiltForward = constrain(tilt, _neck->minTiltForward(), _neck->maxTiltForward());
+
+	_neck->rotateHead(headRotate + _calHeadRotate, HuyangGaze_FOLLOW_TIME, MotionAxis::Linear);
+	_neck->tiltNeckForward(neckTiltForward + _calNeckTiltForward, HuyangGaze_FOLLOW_TIME, MotionAxis::Linear);
+	_body->rotateBody(bodyRotate + _calBodyRotate, HuyangGaze_FOLLOW_TIME);
+}
+
+int32_t HuyangGaze::atanQ8(uint32_t ratio)
+{
+	uint32_t index = ratio >> 11; // 32 table segments over 0..1
+	if (index >= 32)
+	{
+		return pgm_read_word(&HuyangGaze_atanTable[32]);
+	}
+	int32_t fraction = ratio & 0x7FF;
+	int32_t from = pgm_read_word(&HuyangGaze_atanTable[index]);
+	int32_t to = pgm_read_word(&HuyangGaze_atanTable[index + 1]);
+	return from + (((to - from) * fraction) >> 11);
+}
+
+int32_t HuyangGaze::atan2Q8(int32_t y, int32_t x)
+{
+	uint32_t ax = abs(x);
+	uint32_t ay = abs(y);
+	if (ax == 0 && ay == 0)
+	{
+		return 0;
+	}
+
+	// Reduce to the first octant, where the ratio stays between 0 and 1
+	int32_t angle;
+	if (ay <= ax)
+	{
+		angle = atanQ8((ay << 16) / ax);
+	}
+	else
+	{
+		angle = motionToQ8(90) - atanQ8((ax << 16) / ay);
+	}
+
+	if (x < 0)
+	{
+		angle = motionToQ8(180) - angle;
+	}
+	if (y < 0)
+	{
+		angle = -angle;
+	}
+	return angle;
+}
@@ -0,0 +1,58 @@
+#ifndef HuyangGaze_h
+#define HuyangGaze_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+#include "../HuyangNeck/HuyangNeck.h"
+#include "../HuyangBody/HuyangBody.h"
+
+// Angles of the droid at full input (100), adjust to the build of your droid
+#define HuyangGaze_HEAD_YAW 55   // Head rotation servo uses 0-110 degrees
+#define HuyangGaze_BODY_YAW 35   // Body rotation servo uses 0-70 degrees
+#define HuyangGaze_NECK_PITCH 50 // Neck servo uses 0-100 degrees over the forward tilt range
+
+// Time in ms the axes take to catch up with a new solution.
+// Every tick starts a new linear move of this length, so a moving target is followed without stops.
+#define HuyangGaze_FOLLOW_TIME 300
+
+// Turns a point in space into head rotation, neck tilt and body rotation.
+// Coordinates are in mm from the neck pivot: x to the right, y up, z forward (away from the face).
+// The head turns first, the body only takes the part of the rotation the head cannot reach.
+class HuyangGaze
+{
+public:
+	HuyangGaze(HuyangNeck *neck, HuyangBody *body);
+
+	// Sets the point to look at, loop() follows it. Cheap to repeat with the same point every tick.
+	void lookAt(int16_t x, int16_t y, int16_t z);
+	// Calibration offsets added to the solution before it is sent, like the manual inputs get them
+	void setCalibration(int16_t headRotate, int16_t neckTiltForward, int16_t bodyRotate);
+
+	// Solves the current point and moves the axes, call once per control tick while the point is followed
+	void loop();
+
+	// Last solution as axis inputs (-100 to 100), before calibration is added
+	int16_t headRotate = 0;
+	int16_t neckTiltForward = 0;
+	int16_t bodyRotate = 0;
+
+private:
+	HuyangNeck *_neck;
+	HuyangBody *_body;
+
+	int16_t _x = 0;
+	int16_t _y = 0;
+	int16_t _z = 1000;
+	uint32_t _horizontal = 1000; // Distance of the point in the horizontal plane, only solved again when x or z change
+
+	int16_t _calHeadRotate = 0;
+	int16_t _calNeckTiltForward = 0;
+	int16_t _calBodyRotate = 0;
+
+	// Angle of the vector (x, y) against the x axis in Q8 degrees (-180 to 180)
+	int32_t atan2Q8(int32_t y, int32_t x);
+	// atan of a Q16 ratio between 0 and 1 in Q8 degrees
+	int32_t atanQ8(uint32_t ratio);
+};
+
+#endif
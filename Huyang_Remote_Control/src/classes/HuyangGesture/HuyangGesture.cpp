@@ -0,0 +1,212 @@
+#include "HuyangGesture.h"
+
+// Oscillator of a gesture. Amplitude in percent of the gesture amplitude, frequency as a multiple of the gesture
+// frequency, attack and decay in percent of the gesture duration, so every gesture scales with its parameters.
+struct HuyangGesture_Voice
+{
+	uint8_t gesture;
+	uint8_t axis; // HuyangGesture_ROTATE.. for the neck, + HuyangGesture_DIRECTIONS for the body
+	bool sine;
+	int8_t amplitude;
+	uint8_t frequency;
+	uint8_t attack;
+	uint8_t decay;
+};
+
+#define HuyangGesture_BODY(direction) (HuyangGesture_DIRECTIONS + (direction))
+
+static const HuyangGesture_Voice HuyangGesture_voices[] = {
+	{HuyangGesture::Nod, HuyangGesture_TILT_FORWARD, true, 100, 1, 15, 35},
+	{HuyangGesture::Nod, HuyangGesture_BODY(HuyangGesture_TILT_FORWARD), true, 15, 1, 15, 35},
+
+	{HuyangGesture::Shake, HuyangGesture_ROTATE, true, 100, 1, 10, 35},
+	{HuyangGesture::Shake, HuyangGesture_TILT_SIDEWAYS, true, 10, 1, 10, 35},
+
+	{HuyangGesture::TiltCurious, HuyangGesture_TILT_SIDEWAYS, false, 100, 1, 25, 30},
+	{HuyangGesture::TiltCurious, HuyangGesture_TILT_FORWARD, false, 20, 1, 30, 30},
+	{HuyangGesture::TiltCurious, HuyangGesture_ROTATE, false, 10, 1, 30, 30},
+
+	{HuyangGesture::Shrug, HuyangGesture_TILT_FORWARD, false, -100, 1, 25, 40},
+	{HuyangGesture::Shrug, HuyangGesture_BODY(HuyangGesture_TILT_FORWARD), false, -50, 1, 30, 40},
+	{HuyangGesture::Shrug, HuyangGesture_TILT_SIDEWAYS, true, 40, 2, 20, 40},
+
+	{HuyangGesture::Startle, HuyangGesture_TILT_FORWARD, false, -100, 1, 5, 65},
+	{HuyangGesture::Startle, HuyangGesture_BODY(HuyangGesture_TILT_FORWARD), false, -25, 1, 10, 60},
+	{HuyangGesture::Startle, HuyangGesture_ROTATE, true, 15, 8, 5, 80}};
+
+// Defaults of each gesture: amplitude in input units, frequency in Q8 Hz, cycles
+static const int16_t HuyangGesture_defaultAmplitude[HuyangGesture::GestureCount] = {25, 30, 45, 20, 35};
+static const uint16_t HuyangGesture_defaultFrequency[HuyangGesture::GestureCount] = {512, 640, 102, 205, 128};
+static const uint8_t HuyangGesture_defaultCount[HuyangGesture::GestureCount] = {2, 3, 1, 1, 1};
+
+static const char *const HuyangGesture_names[HuyangGesture::GestureCount] = {"nod", "shake", "tilt_curious", "shrug", "startle"};
+
+HuyangGesture::HuyangGesture(MotionAxis *motion, HuyangNeck *neck, HuyangBody *body)
+{
+	_motion = motion;
+	_neck = neck;
+	_body = body;
+
+	for (uint8_t axis = 0; axis < HuyangGesture_AXES; axis++)
+	{
+		if (axis < HuyangGesture_DIRECTIONS)
+		{
+			_axis[axis] = _neck->gestureAxis(axis);
+		}
+		else
+		{
+			_axis[axis] = _body->gestureAxis(axis - HuyangGesture_DIRECTIONS);
+		}
+		_from[axis] = 0;
+		_offset[axis] = 0;
+	}
+}
+
+void HuyangGesture::play(Gesture gesture, int16_t amplitude, uint16_t frequency, uint8_t count)
+{
+	if (gesture >= GestureCount)
+	{
+		return;
+	}
+
+	amplitude = constrain(amplitude != 0 ? amplitude : HuyangGesture_defaultAmplitude[gesture], -100, 100);
+	frequency = constrain(frequency != 0 ? frequency : HuyangGesture_defaultFrequency[gesture], 26, 2560); // 0.1 to 10 Hz
+	count = count != 0 ? count : HuyangGesture_defaultCount[gesture];
+
+	uint32_t duration = (uint32_t)count * 256000UL / frequency;
+	if (duration > HuyangGesture_MAX_DURATION)
+	{
+		count = max((uint32_t)HuyangGesture_MAX_DURATION * frequency / 256000, (uint32_t)1);
+		duration = (uint32_t)count * 256000UL / frequency;
+	}
+
+	// Whatever the previous gesture left on the layers is faded out while the new one comes in
+	for (uint8_t axis = 0; axis < HuyangGesture_AXES; axis++)
+	{
+		_from[axis] = _offset[axis];
+	}
+
+	_voices = 0;
+	for (uint8_t i = 0; i < sizeof(HuyangGesture_voices) / sizeof(HuyangGesture_voices[0]); i++)
+	{
+		const HuyangGesture_Voice &voice = HuyangGesture_voices[i];
+		if (voice.gesture != gesture || _voices >= HuyangGesture_MAX_VOICES)
+		{
+			continue;
+		}
+
+		_voiceAxis[_voices] = voice.axis;
+		_voiceSine[_voices] = voice.sine;
+		_voiceAmplitude[_voices] = axisOffset(voice.axis, amplitude * voice.amplitude / 100);
+		_voiceStep[_voices] = (uint32_t)frequency * voice.frequency * 65536UL / 1000; // Q8 Hz to Q24 cycles per ms
+		_voiceAttack[_voices] = duration * voice.attack / 100;
+		_voiceDecay[_voices] = duration * voice.decay / 100;
+		_voices++;
+	}
+
+	_start = _motion->now();
+	_duration = duration;
+	_attack = _voiceAttack[0];
+	_active = true;
+}
+
+void HuyangGesture::stop(uint16_t fadeTime)
+{
+	if (_active == false)
+	{
+		return;
+	}
+
+	// No oscillators left, only the fade of the last offsets
+	for (uint8_t axis = 0; axis < HuyangGesture_AXES; axis++)
+	{
+		_from[axis] = _offset[axis];
+	}
+	_voices = 0;
+	_start = _motion->now();
+	_duration = max(fadeTime, (uint16_t)1);
+	_attack = _duration;
+}
+
+bool HuyangGesture::isActive()
+{
+	return _active;
+}
+
+void HuyangGesture::tick(unsigned long now)
+{
+	if (_active == false)
+	{
+		return;
+	}
+
+	uint32_t elapsed = now - _start;
+	int32_t offsets[HuyangGesture_AXES];
+
+	if (elapsed >= _duration)
+	{
+		memset(offsets, 0, sizeof(offsets));
+		_active = false;
+	}
+	else
+	{
+		int32_t fade = MotionMath_ONE - motionEaseInOutQuad(motionProgress(elapsed, _attack));
+		for (uint8_t axis = 0; axis < HuyangGesture_AXES; axis++)
+		{
+			offsets[axis] = (_from[axis] * fade) >> 16;
+		}
+
+		for (uint8_t voice = 0; voice < _voices; voice++)
+		{
+			int32_t value = (_voiceAmplitude[voice] * envelope(elapsed, _voiceAttack[voice], _voiceDecay[voice])) >> 16;
+			if (_voiceSine[voice])
+			{
+				// Q24 phase, it wraps after 256 whole cycles so the overflow does not matter
+				value = (value * motionSine((elapsed * _voiceStep[voice]) >> 8)) >> 16;
+			}
+			offsets[_voiceAxis[voice]] += value;
+		}
+	}
+
+	for (uint8_t axis = 0; axis < HuyangGesture_AXES; axis++)
+	{
+		if (offsets[axis] != _offset[axis])
+		{
+			_offset[axis] = offsets[axis];
+			_motion->setPosition(_axis[axis], offsets[axis]);
+		}
+	}
+}
+
+HuyangGesture::Gesture HuyangGesture::find(const char *name)
+{
+	for (uint8_t gesture = 0; gesture < GestureCount; gesture++)
+	{
+		if (strcmp(name, HuyangGesture_names[gesture]) == 0)
+		{
+			return (Gesture)gesture;
+		}
+	}
+	return GestureCount;
+}
+
+const char *HuyangGesture::name(uint8_t gesture)
+{
+	return gesture < GestureCount ? HuyangGesture_names[gesture] : "";
+}
+
+int32_t HuyangGesture::axisOffset(uint8_t axis, int16_t input)
+{
+	if (axis < HuyangGesture_DIRECTIONS)
+	{
+		return _neck->gestureOffset(axis, input);
+	}
+	return _body->gestureOffset(axis - HuyangGesture_DIRECTIONS, input);
+}
+
+int32_t HuyangGesture::envelope(uint32_t elapsed, uint16_t attack, uint16_t decay)
+{
+	int32_t up = motionEaseInOutQuad(motionProgress(elapsed, attack));
+	int32_t down = motionEaseInOutQuad(motionProgress(_duration - elapsed, decay));
+	return min(up, down);
+}
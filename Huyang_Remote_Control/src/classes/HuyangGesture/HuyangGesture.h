@@ -0,0 +1,85 @@
+#ifndef HuyangGesture_h
+#define HuyangGesture_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+#include "../MotionCurves/MotionCurves.h" // Sine table of the oscillators
+#include "../MotionAxis/MotionAxis.h"
+#include "../HuyangNeck/HuyangNeck.h"
+#include "../HuyangBody/HuyangBody.h"
+
+// Directions of the gesture layers of neck and body, see HuyangNeck::gestureAxis()
+#define HuyangGesture_ROTATE 0
+#define HuyangGesture_TILT_FORWARD 1
+#define HuyangGesture_TILT_SIDEWAYS 2
+#define HuyangGesture_DIRECTIONS 3
+#define HuyangGesture_AXES (2 * HuyangGesture_DIRECTIONS) // Neck directions first, then body
+
+#define HuyangGesture_MAX_VOICES 4     // Oscillators of one gesture
+#define HuyangGesture_MAX_DURATION 10000 // ms, longer gestures are cut down to whole cycles that fit
+
+// Procedural gestures (nod, shake, ...) on the gesture layer of neck and body.
+// A gesture is not stored as keyframes but built from a few oscillators, each one a sine or a held pulse on one
+// direction with an attack and decay envelope. Amplitude, frequency and number of cycles are chosen per call, a tick
+// costs one table read and a few multiplications per oscillator.
+//
+// A new gesture fades out what is left of the previous one during its attack, so gestures can be started at any time.
+class HuyangGesture
+{
+public:
+	enum Gesture
+	{
+		Nod = 0,         // Neck forward and back
+		Shake = 1,       // Head left and right
+		TiltCurious = 2, // Head held tilted to the side and leaning in
+		Shrug = 3,       // Head and body lean back for a moment, the head wobbles sideways
+		Startle = 4,     // Quick jerk back with a short tremble, slowly recovering
+		GestureCount = 5
+	};
+
+	HuyangGesture(MotionAxis *motion, HuyangNeck *neck, HuyangBody *body);
+
+	// Starts a gesture. Amplitude in input units (-100 to 100 scale, negative mirrors the gesture),
+	// frequency in Q8 Hz (256 = 1 Hz) and count in cycles, 0 takes the default of the gesture for each.
+	void play(Gesture gesture, int16_t amplitude = 0, uint16_t frequency = 0, uint8_t count = 0);
+	// Fades the running gesture out over fadeTime ms
+	void stop(uint16_t fadeTime = 300);
+	bool isActive();
+
+	// Writes the gesture layer offsets for the given time, call once per control tick before MotionAxis::tick()
+	void tick(unsigned long now);
+
+	// Gesture for a name like "nod" or "tilt_curious", GestureCount if there is none
+	static Gesture find(const char *name);
+	static const char *name(uint8_t gesture);
+
+private:
+	MotionAxis *_motion;
+	HuyangNeck *_neck;
+	HuyangBody *_body;
+
+	uint8_t _axis[HuyangGesture_AXES];   // Gesture layer axis of each direction
+	int32_t _from[HuyangGesture_AXES];   // Offset when the gesture started, faded out during the attack
+	int32_t _offset[HuyangGesture_AXES]; // Offset written by the last tick
+
+	bool _active = false;
+	unsigned long _start = 0;
+	uint16_t _duration = 0;
+	uint16_t _attack = 0; // ms of the fade from _from into the gesture
+
+	// Oscillators of the running gesture, one array per field
+	uint8_t _voices = 0;
+	uint8_t _voiceAxis[HuyangGesture_MAX_VOICES];
+	bool _voiceSine[HuyangGesture_MAX_VOICES];         // false = pulse, the envelope alone shapes it
+	int32_t _voiceAmplitude[HuyangGesture_MAX_VOICES]; // Axis units
+	uint32_t _voiceStep[HuyangGesture_MAX_VOICES];     // Phase per ms, Q24 cycles
+	uint16_t _voiceAttack[HuyangGesture_MAX_VOICES];   // ms
+	uint16_t _voiceDecay[HuyangGesture_MAX_VOICES];    // ms
+
+	// Amplitude of an input value in the units of the gesture axis
+	int32_t axisOffset(uint8_t axis, int16_t input);
+	// Q16 envelope: eased ramp up over attack ms and down over the last decay ms of the gesture
+	int32_t envelope(uint32_t elapsed, uint16_t attack, uint16_t decay);
+};
+
+#endif
@@ -1,9 +1,71 @@
 #include "HuyangNeck.h"
-#include <Adafruit_PWMServoDriver.h>
-
-HuyangNeck::HuyangNeck(Adafruit_PWMServoDriver *pwm)
+#include "../HuyangGesture/HuyangGesture.h" // Directions of the gesture layers
+
+// Linkage of the neck tilt servos, see ServoMixer.h.
+// Forward tilt runs from 0 (back) to 200 (forward) internally, sideways tilt from -50 to 50.
+static const ServoMixer::Input HuyangNeck_mixInputs[] = {
+	{0, 200}, // 0: tilt forward
+	{-50, 50} // 1: tilt sideways
+};
+
+static const ServoMixer::Servo HuyangNeck_mixServos[] = {
+	{pwm_pin_head_left, ServoMixer_DEGREE(10), ServoMixer_DEGREE(65)},  // 0
+	{pwm_pin_head_right, ServoMixer_DEGREE(35), ServoMixer_DEGREE(90)}, // 1
+	{pwm_pin_head_neck, ServoMixer_DEGREE(0), ServoMixer_DEGREE(100)}   // 2
+};
+
+// The side servos lean together for forward tilt and against each other for sideways tilt
+static const ServoMixer::Link HuyangNeck_mixLinks[] = {
+	{0, 0, ServoMixer_DEGREE(65), ServoMixer_DEGREE(10)},
+	{0, 1, ServoMixer_DEGREE(13.75), ServoMixer_DEGREE(-13.75)},
+	{1, 0, ServoMixer_DEGREE(35), ServoMixer_DEGREE(90)},
+	{1, 1, ServoMixer_DEGREE(13.75), ServoMixer_DEGREE(-13.75)},
+	{2, 0, ServoMixer_DEGREE(100), ServoMixer_DEGREE(0)}
+};
+
+HuyangNeck::HuyangNeck(PwmBus *bus, MotionAxis *motion)
 {
-	_pwm = pwm;
+	_motion = motion;
+
+	_mixer = new ServoMixer(bus);
+	_mixer->build(HuyangNeck_mixInputs, 2, HuyangNeck_mixServos, 3, HuyangNeck_mixLinks, 5, HuyangNeck_SERVOMIN, HuyangNeck_SERVOMAX);
+
+	// Rotation and monocle drive one servo each, the tilt axes are mixed in updateNeckPosition()
+	_axisRotate = _motion->addAxis(rotationToSubticks(0), pwm_pin_head_rotate);
+	_axisTiltForward = _motion->addAxis(motionToQ8(50));
+	_axisTiltSideways = _motion->addAxis(0);
+	_axisMonocle = _motion->addAxis(degreeToSubticks(motionToQ8(90)), pwm_pin_head_monocle);
+
+	// Joystick input is streamed into the neck, the body axes follow it with their planner
+	_motion->enableQueue(_axisRotate);
+	_motion->enableQueue(_axisTiltForward);
+	_motion->enableQueue(_axisTiltSideways);
+	_motion->enableQueue(_axisMonocle);
+
+	// Idle and gesture motion is added on top of the manual position
+	_idleRotate = _motion->addLayer(_axisRotate, MotionAxis::Idle);
+	_idleTiltForward = _motion->addLayer(_axisTiltForward, MotionAxis::Idle);
+	_idleTiltSideways = _motion->addLayer(_axisTiltSideways, MotionAxis::Idle);
+	_gestureRotate = _motion->addLayer(_axisRotate, MotionAxis::Gesture);
+	_gestureTiltForward = _motion->addLayer(_axisTiltForward, MotionAxis::Gesture);
+	_gestureTiltSideways = _motion->addLayer(_axisTiltSideways, MotionAxis::Gesture);
+	_motion->setOutputRange(_axisRotate, rotationToSubticks(_minRotation), rotationToSubticks(_maxRotation));
+	_motion->setOutputRange(_axisTiltForward, motionToQ8(_minTiltForward), motionToQ8(_maxTiltForward));
+	_motion->setOutputRange(_axisTiltSideways, motionToQ8(-50), motionToQ8(50));
+
+	// Servo model: the axis velocity at which the slowest of its servos turns at full speed
+	int32_t degreesPerSecond = 60000 / HuyangNeck_SERVO_SPEED;
+	_motion->setDynamics(_axisRotate, (rotationToSubticks(_maxRotation) - rotationToSubticks(_minRotation)) * degreesPerSecond / 110, HuyangNeck_SERVO_TIME_CONSTANT);
+	_motion->setDynamics(_axisTiltForward, motionToQ8(200) * degreesPerSecond / 100, HuyangNeck_SERVO_TIME_CONSTANT); // Neck servo turns 100 degrees
+	_motion->setDynamics(_axisTiltSideways, motionToQ8(100) * degreesPerSecond * 2 / 55, HuyangNeck_SERVO_TIME_CONSTANT); // Side servos turn 27.5 degrees
+	_motion->setDynamics(_axisMonocle, (degreeToSubticks(motionToQ8(180)) - degreeToSubticks(0)) * degreesPerSecond / 180, HuyangNeck_SERVO_TIME_CONSTANT);
+
+	// The idle layers follow noise instead of random targets, sideways is scaled like tiltNeckSideways()
+	_idle = new MotionIdle(_motion, 0);
+	_idle->add(_idleRotate, rotationToSubticks(HuyangNeck_IDLE_ROTATE) - rotationToSubticks(0), HuyangNeck_IDLE_ROTATE_FREQUENCY);
+	_idle->add(_idleTiltForward, motionToQ8(HuyangNeck_IDLE_TILT_FORWARD), HuyangNeck_IDLE_TILT_FORWARD_FREQUENCY, motionToQ8(HuyangNeck_IDLE_TILT_FORWARD_CENTER));
+	_idle->add(_idleTiltSideways, motionToQ8(HuyangNeck_IDLE_TILT_SIDEWAYS) / 2, HuyangNeck_IDLE_TILT_SIDEWAYS_FREQUENCY);
+	_idle->breathe(_idleTiltForward, motionToQ8(HuyangNeck_IDLE_BREATH), HuyangNeck_IDLE_BREATH_PERIOD);
 }
 
 void HuyangNeck::setup()
@@ -12,87 +74,37 @@ void HuyangNeck::setup()
 	// Neck servos will be centered based on their default position and calibration in loop()
 }
 
-// Maps a degree value to a PWM pulselength and sends it to the specified servo pin
-void HuyangNeck::rotateServo(uint8_t servo, double degree)
-{
-	// Map the input degree (0-180 for standard servos) to the PCA9685 pulse length range
-	uint16_t pulselength = map(degree, 0, 180, HuyangNeck_SERVOMIN, HuyangNeck_SERVOMAX);
-
-	// Set the PWM output for the specified servo pin
-	_pwm->setPWM(servo, 0, pulselength);
-}
-
-// Easing function: Ease-in-out quadratic
-double HuyangNeck::easeInOutQuad(double t)
+// Converts a Q8 servo angle (0-180) to sub-ticks in the PCA9685 pulse length range
+int32_t HuyangNeck::degreeToSubticks(int32_t degreeQ8)
 {
-	return t < 0.5 ? 2 * t * t : t * (4 - 2 * t) - 1;
+	return motionDegreeQ8ToSubticks(degreeQ8, HuyangNeck_SERVOMIN, HuyangNeck_SERVOMAX);
 }
 
-// Generic easing function to calculate intermediate position
-double HuyangNeck::easeInAndOut(double start, double current, double target, double percentage)
+// Converts a head rotation input to sub-ticks, the rotation servo uses 0-110 degrees
+int32_t HuyangNeck::rotationToSubticks(int16_t degree)
 {
-	double result = target; // Default to target if percentage is >= 1.0
-
-	if (percentage > 1.0)
-	{
-		percentage = 1.0; // Cap percentage at 1.0 (100%)
-	}
-
-	if (current != target) // Only calculate if movement is needed
-	{
-		double easeInOut = easeInOutQuad(percentage); // Get eased percentage
-
-		if (current < target)
-		{
-			double subTarget = (target - start);
-			result = start + (subTarget * easeInOut);
-			if (result > target) { // Ensure we don't overshoot
-				result = target;
-			}
-		}
-		else if (current > target)
-		{
-			double subTarget = (start - target);
-			result = start - (subTarget * easeInOut);
-			if (result < target) { // Ensure we don't overshoot
-				result = target;
-			}
-		}
-	}
-	return result;
+	int32_t rotateDegree = motionMap(motionToQ8(degree), motionToQ8(_minRotation), motionToQ8(_maxRotation), 0, motionToQ8(110));
+	return degreeToSubticks(rotateDegree);
 }
 
 // Main loop for HuyangNeck, called repeatedly from system.h
 void HuyangNeck::loop()
 {
-	_currentMillis = millis(); // Get current time
-
-	// Reset previousMillis if system time rolls over
-	if (_previousMillis > _currentMillis)
-	{
-		_previousMillis = _currentMillis;
-	}
-
-	// Update servo positions based on target and easing
-	updateCurrentRotate();
-	updateNeckPosition(); // Updates tilt forward and sideways
+	// Mix the tilt axes of this tick into the neck servos
+	updateNeckPosition();
+}
 
-	// If in automatic mode, trigger random movements
-	if (automatic == true)
-	{
-		doRandomRotate();
-		doRandomTiltForward();
-		doRandomTiltSideways(); // Call random sideways tilt
-	}
+void HuyangNeck::tickIdle(unsigned long now)
+{
+	// How much of the idle motion is visible is set by the layer weight
+	_idle->tick(now);
 }
 
 // --- Neck Movement Control Functions ---
 
 // Controls head rotation
-void HuyangNeck::rotateHead(double degree, double duration)
+void HuyangNeck::rotateHead(int16_t degree, uint16_t duration, MotionAxis::Curve curve)
 {
-	// Apply calibration offset
-	degree += calibrationRotate; // Use the member variable from HuyangNeck class
 	// Constrain degree within allowed range
 	degree = constrain(degree, _minRotation, _maxRotation);
 
@@ -100,22 +112,18 @@ void HuyangNeck::rotateHead(double degree, double duration)
 	{
 		if (duration == 0) // Calculate duration if not provided (based on distance)
 		{
-			double way = abs(degree - _currentRotate); // Distance to move
+			uint16_t way = abs(degree - targetRotate); // Distance to move
 			duration = way * 16; // Adjust this multiplier for desired speed
 		}
 
-		_startRotate = _currentRotate; // Store starting point for easing
-		targetRotate = degree;         // Set new target
-		_rotationDuration = duration;  // Set movement duration
-		_rotationStartMillis = _currentMillis; // Record start time of movement
+		targetRotate = degree;
+		_motion->moveTo(_axisRotate, rotationToSubticks(degree), duration, curve);
 	}
 }
 
 // Controls neck tilt forward/backward
-void HuyangNeck::tiltNeckForward(double degree, double duration)
+void HuyangNeck::tiltNeckForward(int16_t degree, uint16_t duration, MotionAxis::Curve curve)
 {
-	// Apply calibration offset
-	degree += calibrationTiltForward; // Use the member variable from HuyangNeck class
 	// Adjust degree for internal mapping, then constrain
 	degree = degree + 100; // Shifts -100 to 100 range to 0 to 200 for mapping
 	degree = constrain(degree, _minTiltForward, _maxTiltForward);
@@ -124,22 +132,18 @@ void HuyangNeck::tiltNeckForward(double degree, double duration)
 	{
 		if (duration == 0) // Calculate duration if not provided
 		{
-			double way = abs(degree - _currentTiltForward);
+			uint16_t way = abs(motionToQ8(degree) - _motion->position(_axisTiltForward)) >> MotionMath_Q8;
 			duration = way * 16;
 		}
 
-		_startTiltForward = _currentTiltForward;
 		targetTiltForward = degree;
-		_tiltForwardDuration = duration;
-		_tiltForwardStartMillis = _currentMillis;
+		_motion->moveTo(_axisTiltForward, motionToQ8(degree), duration, curve);
 	}
 }
 
 // Controls neck tilt sideways
-void HuyangNeck::tiltNeckSideways(double degree)
+void HuyangNeck::tiltNeckSideways(int16_t degree, uint16_t duration, MotionAxis::Curve curve)
 {
-	// Apply calibration offset
-	degree += calibrationTiltSideways; // Use the member variable from HuyangNeck class
 	// Constrain degree within allowed range
 	degree = constrain(degree, _minTiltSideways, _maxTiltSideways);
 
@@ -149,130 +153,90 @@ void HuyangNeck::tiltNeckSideways(double degree)
 
 	if (targetTiltSideways != degree) // Only update if target has changed
 	{
-		_startTiltSideways = _currentTiltSideways; // Store starting point for easing
-		targetTiltSideways = degree;              // Set new target
-		_tiltSidewaysPercentage = 0.0;            // Reset easing percentage
+		targetTiltSideways = degree;
+		_motion->moveTo(_axisTiltSideways, motionToQ8(degree), duration, curve);
 	}
 }
 
-
-// --- Internal Update Functions for Easing ---
-
-// Updates the current rotation position using easing
-void HuyangNeck::updateCurrentRotate()
+// Controls the monocle servo inside the head shell
+void HuyangNeck::moveMonocle(int16_t degree, uint16_t duration, MotionAxis::Curve curve)
 {
-	if (_currentRotate != targetRotate) // If still moving towards target
+	degree = constrain(degree, _minMonocle, _maxMonocle);
+
+	if (targetMonocle != degree) // Only update if target has changed
 	{
-		// Calculate easing percentage based on time elapsed
-		double percentage = (double)(_currentMillis - _rotationStartMillis) / _rotationDuration;
-		// Update current position using easing function
-		_currentRotate = easeInAndOut(_startRotate, _currentRotate, targetRotate, percentage);
-
-		// Map the internal rotation value to the servo's actual degree range (0-110 for example)
-		uint16_t rotateDegree = map(_currentRotate, _minRotation, _maxRotation, 0, 110);
-		rotateServo(pwm_pin_head_rotate, rotateDegree); // Send command to servo
+		targetMonocle = degree;
+		// -90 to 90 maps to the full 0-180 degree range of the servo
+		_motion->moveTo(_axisMonocle, degreeToSubticks(motionToQ8(degree + 90)), duration, curve);
 	}
 }
 
-// Updates the current neck tilt forward and sideways positions using easing
-void HuyangNeck::updateNeckPosition()
-{
-	// Update forward tilt position
-	if (_currentTiltForward != targetTiltForward)
-	{
-		double tiltForwardPercentage = (double)(_currentMillis - _tiltForwardStartMillis) / _tiltForwardDuration;
-		_currentTiltForward = easeInAndOut(_startTiltForward, _currentTiltForward, targetTiltForward, tiltForwardPercentage);
-	}
 
-	// Update sideways tilt position (using a simple percentage increment for now)
-	// This might need more sophisticated easing if a `duration` parameter is added to `tiltNeckSideways`
-	if (_currentTiltSideways != targetTiltSideways)
-	{
-		_currentTiltSideways = easeInAndOut(_startTiltSideways, _currentTiltSideways, targetTiltSideways, _tiltSidewaysPercentage);
-		_tiltSidewaysPercentage += 0.06; // Increment percentage for gradual movement
-		if (_tiltSidewaysPercentage > 1.0) _tiltSidewaysPercentage = 1.0;
-	}
+// --- Input Limits ---
 
-	// Calculate individual servo degrees based on combined forward and sideways tilt
-	// These mappings are crucial for coordinating multiple servos for complex movements.
-	uint16_t leftDegree = map(_currentTiltForward + _currentTiltSideways, 0, 200, 65, 10);
-	uint16_t rightDegree = map(_currentTiltForward - _currentTiltSideways, 0, 200, 35, 90);
-	uint16_t neckDegree = map(_currentTiltForward, 0, 200, 100, 0);
-
-	// Constrain final servo degrees to their physical limits
-	leftDegree = constrain(leftDegree, (uint16_t)10, (uint16_t)65);
-	rightDegree = constrain(rightDegree, (uint16_t)35, (uint16_t)90);
-	neckDegree = constrain(neckDegree, (uint16_t)0, (uint16_t)100);
-
-	// Send commands to respective servos
-	rotateServo(pwm_pin_head_left, leftDegree);
-	rotateServo(pwm_pin_head_right, rightDegree);
-	rotateServo(pwm_pin_head_neck, neckDegree);
+int16_t HuyangNeck::minRotation()
+{
+	return _minRotation;
 }
 
-// --- Random Movement Functions (for automatic mode) ---
-
-void HuyangNeck::doRandomRotate()
+int16_t HuyangNeck::maxRotation()
 {
-	if (_randomDoRotate == 0) // If no random rotation is scheduled
-	{
-		// Schedule next random rotation after an initial delay + random interval
-		_randomDoRotate = _currentMillis + 2000 + (random(6, 12 + 1) * 1000);
-	}
-
-	if (_currentMillis > _randomDoRotate) // If scheduled time has passed
-	{
-		_randomDoRotate = 0; // Reset schedule
-
-		// Randomly choose to rotate left or right
-		if (_currentRotate > 0) // If currently rotated right, rotate left
-		{
-			rotateHead(-(random(10, 80 + 1)), random(2, 6 + 1) * 1000);
-		}
-		else // If currently rotated left or center, rotate right
-		{
-			rotateHead(random(10, 80 + 1), random(2, 6 + 1) * 1000);
-		}
-	}
+	return _maxRotation;
 }
 
-void HuyangNeck::doRandomTiltForward()
+// Forward tilt is stored shifted to 0..200, the limits are returned on the input scale
+int16_t HuyangNeck::minTiltForward()
 {
-	if (_randomDoTiltForward == 0) // If no random forward tilt is scheduled
-	{
-		// Schedule next random tilt after an initial delay + random interval
-		_randomDoTiltForward = _currentMillis + 2500 + (random(6, 12 + 1) * 1050);
-	}
+	return _minTiltForward - 100;
+}
 
-	if (_currentMillis > _randomDoTiltForward) // If scheduled time has passed
-	{
-		_randomDoTiltForward = 0; // Reset schedule
+int16_t HuyangNeck::maxTiltForward()
+{
+	return _maxTiltForward - 100;
+}
 
-		double workArea = 60;  // Range for random tilt
-		double center = -15;   // Center point for tilt
+// --- Gesture Layer ---
 
-		// Generate random tilt within a range around the center
-		tiltNeckForward(random(center - workArea, center + workArea + 1), random(3, 6 + 1) * 1000);
-	}
+uint8_t HuyangNeck::gestureAxis(uint8_t direction)
+{
+	const uint8_t axes[] = {_gestureRotate, _gestureTiltForward, _gestureTiltSideways};
+	return axes[direction];
 }
 
-// Function for random sideways tilt (for automatic mode)
-void HuyangNeck::doRandomTiltSideways()
+// Same scaling as rotateHead(), tiltNeckForward() and tiltNeckSideways(), without the offset of the neutral position
+int32_t HuyangNeck::gestureOffset(uint8_t direction, int16_t input)
 {
-	if (_randomDoTiltSideways == 0) // If no random sideways tilt is scheduled
+	switch (direction)
 	{
-		// Schedule next random tilt after an initial delay + random interval
-		_randomDoTiltSideways = _currentMillis + 3000 + (random(5, 10 + 1) * 1100);
+	case HuyangGesture_ROTATE:
+		return rotationToSubticks(input) - rotationToSubticks(0);
+	case HuyangGesture_TILT_FORWARD:
+		return motionToQ8(input);
+	default:
+		return motionToQ8(input) / 2; // Sideways input -100 to 100 is -50 to 50 internally
 	}
+}
 
-	if (_currentMillis > _randomDoTiltSideways) // If scheduled time has passed
+// Inverse of the scaling in rotateHead(), tiltNeckForward() and tiltNeckSideways()
+int16_t HuyangNeck::estimate(uint8_t direction)
+{
+	switch (direction)
 	{
-		_randomDoTiltSideways = 0; // Reset schedule
+	case HuyangGesture_ROTATE:
+		return motionMap(_motion->estimate(_axisRotate), rotationToSubticks(_minRotation), rotationToSubticks(_maxRotation), _minRotation, _maxRotation);
+	case HuyangGesture_TILT_FORWARD:
+		return motionFromQ8(_motion->estimate(_axisTiltForward)) - 100;
+	default:
+		return motionFromQ8(_motion->estimate(_axisTiltSideways) * 2);
+	}
+}
 
-		double workArea = 30; // Range for random tilt
-		double center = 0;    // Center point for tilt
+// --- Servo Mixing ---
 
-		// Generate random tilt within a range around the center
-		tiltNeckSideways(random(center - workArea, center + workArea + 1)); // Duration not specified for this one in webserver
-	}
+// Mixes the current neck tilt forward and sideways positions into the three tilt servos
+void HuyangNeck::updateNeckPosition()
+{
+	// Same order as HuyangNeck_mixInputs, the bus only sends the servos that changed
+	int32_t inputs[] = {_motion->output(_axisTiltForward), _motion->output(_axisTiltSideways)};
+	_mixer->update(inputs);
 }
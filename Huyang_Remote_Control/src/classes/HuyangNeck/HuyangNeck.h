@@ -2,15 +2,38 @@
 #define HuyangNeck_h
 
 #include "Arduino.h"
-#include <Adafruit_PWMServoDriver.h>
-#include "../EasingServo.h" // Include EasingServo for smooth movements
+#include "../PwmBus/PwmBus.h" // Shared servo outputs of all PCA9685 boards
+#include "../MotionAxis/MotionAxis.h" // Shared axis table that eases all movements
+#include "../ServoMixer/ServoMixer.h" // Lookup tables from the tilt axes to the three tilt servos
+#include "../MotionIdle/MotionIdle.h" // Noise and breathing of the idle layer
 
 // Servo Parameters for PCA9685 PWM Driver
 #define HuyangNeck_SERVOMIN 150	 // This is the 'minimum' pulse length count (out of 4096)
 #define HuyangNeck_SERVOMAX 595	 // This is the 'maximum' pulse length count (out of 4096)
 #define HuyangNeck_SERVO_FREQ 60 // Analog servos typically run at ~50 Hz updates, 60 is fine for PCA9685
 
-// PWM channel pins for neck servos on the PCA9685 board
+// Entries the neck takes in the MotionAxis table: rotation, both tilts and the monocle,
+// plus an idle and a gesture layer on the rotation and both tilts
+#define HuyangNeck_AXES 10
+
+// Servo model for the estimated pose (see MotionAxis::setDynamics()): data sheet speed in ms per 60 degrees
+// at the supply voltage of the droid, and the time constant in ms of the servo control loop
+#define HuyangNeck_SERVO_SPEED 120
+#define HuyangNeck_SERVO_TIME_CONSTANT 40
+
+// Idle motion: how far each axis wanders (input units, -100 to 100 scale) and how often it turns (Q8 Hz)
+#define HuyangNeck_IDLE_ROTATE 60
+#define HuyangNeck_IDLE_ROTATE_FREQUENCY 31     // ~0.12 Hz
+#define HuyangNeck_IDLE_TILT_FORWARD 45
+#define HuyangNeck_IDLE_TILT_FORWARD_CENTER -15 // Looks slightly up while idle
+#define HuyangNeck_IDLE_TILT_FORWARD_FREQUENCY 38
+#define HuyangNeck_IDLE_TILT_SIDEWAYS 30
+#define HuyangNeck_IDLE_TILT_SIDEWAYS_FREQUENCY 46
+// The head tilts a little against the breathing of the body, so it stays level
+#define HuyangNeck_IDLE_BREATH -2
+#define HuyangNeck_IDLE_BREATH_PERIOD 4500 // Same as HuyangBody_IDLE_BREATH_PERIOD
+
+// PWM channels of the neck servos, logical channels of the PWM bus: PwmBus_CHANNEL(board, output) for boards after the first
 #define pwm_pin_head_monocle (uint8_t)4 // Servo for monacle movement
 #define pwm_pin_head_left (uint8_t)5    // Left neck servo for tilt
 #define pwm_pin_head_right (uint8_t)6   // Right neck servo for tilt
@@ -20,81 +43,81 @@
 class HuyangNeck
 {
 public:
-	// Constructor: takes a pointer to the PWM driver
-	HuyangNeck(Adafruit_PWMServoDriver *pwm);
+	// Constructor: takes the shared PWM bus and the axis table the neck registers its axes in
+	HuyangNeck(PwmBus *bus, MotionAxis *motion);
 
 	// Setup function: performs initial servo centering or setup
 	void setup();
-	// Loop function: called repeatedly to update servo positions and handle automatic animations
+	// Loop function: called once per control tick after MotionAxis::tick() to update servo positions
 	void loop();
+	// Writes the idle layer offsets for the given time, call once per control tick before MotionAxis::tick()
+	void tickIdle(unsigned long now);
 
-	// Public control functions for neck movements
-	void tiltNeckSideways(double degree);
-	void tiltNeckForward(double degree, double duration = 1000);
-	void rotateHead(double degree, double duration = 1000);
+	// Public control functions for neck movements, each move can pick its own easing curve
+	void tiltNeckSideways(int16_t degree, uint16_t duration = 1000, MotionAxis::Curve curve = MotionAxis::EaseInOutQuad);
+	void tiltNeckForward(int16_t degree, uint16_t duration = 1000, MotionAxis::Curve curve = MotionAxis::EaseInOutQuad);
+	void rotateHead(int16_t degree, uint16_t duration = 1000, MotionAxis::Curve curve = MotionAxis::EaseInOutQuad);
+	void moveMonocle(int16_t degree, uint16_t duration = 500, MotionAxis::Curve curve = MotionAxis::EaseInOutQuad);
 
-	// Flag to enable/disable automatic (random) animations
-	bool automatic = true;
+	// Input limits (-100 to 100 scale), used by HuyangGaze to split a movement between neck and body
+	int16_t minRotation();
+	int16_t maxRotation();
+	int16_t minTiltForward();
+	int16_t maxTiltForward();
 
-	// Target degrees for manual control (set by web server)
-	double targetTiltSideways = 0;
-	double targetTiltForward = 0;
-	double targetRotate = 0;
+	// Gesture layer of a direction (HuyangGesture_ROTATE, _TILT_FORWARD, _TILT_SIDEWAYS), driven by HuyangGesture
+	uint8_t gestureAxis(uint8_t direction);
+	// Offset of an input value (-100 to 100 scale) in the units of that gesture layer
+	int32_t gestureOffset(uint8_t direction, int16_t input);
 
-	// --- NEW: Calibration offsets ---
-	// These values will be added/subtracted to the target degrees
-	// before mapping to pulse lengths, effectively shifting the servo's range.
-	int16_t calibrationRotate = 0;
-	int16_t calibrationTiltForward = 0;
-	int16_t calibrationTiltSideways = 0;
+	// Where the servos of a direction (HuyangGesture_ROTATE, ...) really are, estimated from their speed.
+	// Input scale like the target values, including idle and gesture motion.
+	int16_t estimate(uint8_t direction);
+
+	// Target values for manual control (set by web server), already constrained to the internal ranges
+	int16_t targetTiltSideways = 0;
+	int16_t targetTiltForward = 0;
+	int16_t targetRotate = 0;
+	int16_t targetMonocle = 0;
 
 
 private:
-	Adafruit_PWMServoDriver *_pwm; // Pointer to the PWM driver instance
-
-	unsigned long _currentMillis = 0;  // Current time in milliseconds
-	unsigned long _previousMillis = 0; // Previous time for general timing
-	
-	// Timers for random automatic movements
-	unsigned long _randomDoRotate = 0;
-	unsigned long _randomDoTiltForward = 0;
-	unsigned long _randomDoTiltSideways = 0; // NEW: For random sideways tilt
-
-	// Internal state variables for smooth movement easing
-	double _currentTiltSideways = 0;
-	double _minTiltSideways = -100; // Min value for sideways tilt input
-	double _maxTiltSideways = 100;  // Max value for sideways tilt input
-	double _startTiltSideways = 0;  // Starting position for current sideways tilt movement
-	double _tiltSidewaysPercentage = 1.0; // Easing percentage for sideways tilt
-
-	double _currentTiltForward = 50; // Current forward tilt position
-	double _minTiltForward = 0;      // Min value for forward tilt input
-	double _maxTiltForward = 200;    // Max value for forward tilt input
-	double _startTiltForward = 50;   // Starting position for current forward tilt movement
-	double _tiltForwardDuration = 0; // Duration of forward tilt movement
-	unsigned long _tiltForwardStartMillis = 0; // Start time of forward tilt movement
-
-	double _currentRotate = 0;   // Current rotation position
-	double _minRotation = -100;  // Min value for rotation input
-	double _maxRotation = 100;   // Max value for rotation input
-	double _startRotate = 0;     // Starting position for current rotation movement
-	double _rotationDuration = 0; // Duration of rotation movement
-	unsigned long _rotationStartMillis = 0; // Start time of rotation movement
+	// Axes in the shared MotionAxis table.
+	// Tilt axes are Q8 fixed-point (value << 8) and mixed into three servos here,
+	// rotation and monocle are kept in servo sub-ticks and written by the table itself (see MotionMath.h).
+	MotionAxis *_motion;
+	ServoMixer *_mixer; // Tilt forward and sideways into the left, right and neck servos
+	uint8_t _axisRotate;
+	uint8_t _axisTiltForward;
+	uint8_t _axisTiltSideways;
+	uint8_t _axisMonocle;
+
+	// Offsets of the idle and gesture layers, same units as their base axis
+	uint8_t _idleRotate;
+	uint8_t _idleTiltForward;
+	uint8_t _idleTiltSideways;
+	uint8_t _gestureRotate;
+	uint8_t _gestureTiltForward;
+	uint8_t _gestureTiltSideways;
+	MotionIdle *_idle; // Drives the idle layers
+
+	int16_t _minTiltSideways = -100; // Min value for sideways tilt input
+	int16_t _maxTiltSideways = 100;  // Max value for sideways tilt input
+	int16_t _minTiltForward = 0;     // Min value for forward tilt input
+	int16_t _maxTiltForward = 200;   // Max value for forward tilt input
+	int16_t _minRotation = -100;     // Min value for rotation input
+	int16_t _maxRotation = 100;      // Max value for rotation input
+	int16_t _minMonocle = -90;       // Min value for monocle input
+	int16_t _maxMonocle = 90;        // Max value for monocle input
 
 	// Private helper methods
-	// Maps a degree value to a PWM pulselength and sends it to the specified servo pin
-	void rotateServo(uint8_t servo, double degree);
-	// Easing function for smooth animation (quadrilateral ease-in-out)
-	double easeInOutQuad(double t);
-	// Generic easing function to calculate intermediate position
-	double easeInAndOut(double start, double current, double target, double percentage);
-
-	// Update functions for each type of neck movement, applying easing and calibration
+	// Converts a Q8 servo angle (0-180) to sub-ticks
+	int32_t degreeToSubticks(int32_t degreeQ8);
+	// Converts a head rotation input (-100 to 100) to sub-ticks of the rotation servo
+	int32_t rotationToSubticks(int16_t degree);
+
+	// Mixes the eased tilt axes into the left, right and neck servos
 	void updateNeckPosition();
-	void updateCurrentRotate();
-	void doRandomRotate();
-	void doRandomTiltForward();
-	void doRandomTiltSideways(); // NEW: For random sideways tilt
 };
 
 #endif
@@ -0,0 +1,210 @@
+#include "HuyangSequencer.h"
+
+HuyangSequencer::HuyangSequencer(MotionClock *clock, HuyangNeck *neck, HuyangBody *body, HuyangFace *face)
+{
+	_clock = clock;
+	_neck = neck;
+	_body = body;
+	_face = face;
+}
+
+bool HuyangSequencer::play(const char *path, bool loop, uint16_t speed)
+{
+	stop();
+
+	_file.file = LittleFS.open(path, "r");
+	if (!_file.file)
+	{
+		Serial.printf("HuyangSequencer: cannot open %s\n", path);
+		return false;
+	}
+
+	if (_clip.begin(&_file) == false)
+	{
+		Serial.printf("HuyangSequencer: %s is no HYC2 clip\n", path);
+		_file.file.close();
+		return false;
+	}
+
+	_loop = loop;
+	setSpeed(speed);
+	_clipTime = 0;
+	_remainder = 0;
+	_lastMillis = _clock->now();
+	_hasNext = _clip.next(_next);
+	_playing = true;
+
+	Serial.printf("HuyangSequencer: playing %s, %lu ms, %lu records\n", path, (unsigned long)_clip.length(), (unsigned long)_clip.recordCount());
+
+	// Records at 0 ms start in this tick already
+	startDueEvents();
+	return true;
+}
+
+void HuyangSequencer::stop()
+{
+	if (_file.file)
+	{
+		_file.file.close();
+	}
+	_playing = false;
+}
+
+void HuyangSequencer::setSpeed(uint16_t speed)
+{
+	_speed = constrain(speed, 10, 1000);
+}
+
+void HuyangSequencer::seek(uint32_t time)
+{
+	if (_playing == false)
+	{
+		return;
+	}
+
+	time = min(time, _clip.length());
+	_clip.seek(time);
+
+	// Pose at the index entry, records up to the time only update it
+	int16_t pose[MotionClip::TrackCount];
+	for (uint8_t track = 0; track < MotionClip::TrackCount; track++)
+	{
+		pose[track] = _clip.value(track);
+	}
+	_hasNext = _clip.next(_next);
+	while (_hasNext && _next.start < time)
+	{
+		pose[_next.track] = _next.value;
+		_hasNext = _clip.next(_next);
+	}
+
+	// Move everything to that pose, eyes and lights that were never set are left alone
+	for (uint8_t track = 0; track < MotionClip::TrackCount; track++)
+	{
+		if (track >= MotionClip::LeftEye && pose[track] == 0)
+		{
+			continue;
+		}
+		apply(track, pose[track], HuyangSequencer_SEEK_TIME, MotionAxis::EaseInOutQuad);
+	}
+
+	_clipTime = time;
+	_remainder = 0;
+}
+
+bool HuyangSequencer::isPlaying()
+{
+	return _playing;
+}
+
+void HuyangSequencer::setCalibration(int16_t neckRotate, int16_t neckTiltForward, int16_t neckTiltSideways, int16_t monocle,
+									 int16_t bodyRotate, int16_t bodyTiltForward, int16_t bodyTiltSideways)
+{
+	_calibration[MotionClip::NeckRotate] = neckRotate;
+	_calibration[MotionClip::NeckTiltForward] = neckTiltForward;
+	_calibration[MotionClip::NeckTiltSideways] = neckTiltSideways;
+	_calibration[MotionClip::Monocle] = monocle;
+	_calibration[MotionClip::BodyRotate] = bodyRotate;
+	_calibration[MotionClip::BodyTiltForward] = bodyTiltForward;
+	_calibration[MotionClip::BodyTiltSideways] = bodyTiltSideways;
+}
+
+void HuyangSequencer::loop()
+{
+	if (_playing == false)
+	{
+		return;
+	}
+
+	// Advance the clip time by the tick time scaled with the speed, the rest of a ms is carried over
+	unsigned long now = _clock->now();
+	uint32_t scaled = (now - _lastMillis) * _speed + _remainder;
+	_lastMillis = now;
+	_clipTime += scaled / 100;
+	_remainder = scaled % 100;
+
+	startDueEvents();
+
+	if (_clipTime >= _clip.length())
+	{
+		if (_loop && _clip.length() > 0 && _clip.rewind())
+		{
+			_clipTime -= _clip.length();
+			_hasNext = _clip.next(_next);
+			startDueEvents();
+		}
+		else
+		{
+			stop();
+		}
+	}
+}
+
+// Only the next record is looked at each tick, everything after it starts later
+void HuyangSequencer::startDueEvents()
+{
+	while (_hasNext && _next.start <= _clipTime)
+	{
+		apply(_next.track, _next.value, _next.duration * 100 / _speed, _next.curve);
+		_hasNext = _clip.next(_next);
+	}
+}
+
+void HuyangSequencer::apply(uint8_t track, int16_t value, uint32_t duration, uint8_t curve)
+{
+	duration = min(duration, (uint32_t)UINT16_MAX);
+
+	MotionAxis::Curve axisCurve = MotionAxis::EaseInOutQuad;
+	if (curve <= MotionAxis::Spring)
+	{
+		axisCurve = (MotionAxis::Curve)curve;
+	}
+	if (track < MotionClip::LeftEye)
+	{
+		value += _calibration[track];
+	}
+
+	switch (track)
+	{
+	case MotionClip::NeckRotate:
+		_neck->rotateHead(value, duration, axisCurve);
+		break;
+	case MotionClip::NeckTiltForward:
+		_neck->tiltNeckForward(value, duration, axisCurve);
+		break;
+	case MotionClip::NeckTiltSideways:
+		_neck->tiltNeckSideways(value, duration, axisCurve);
+		break;
+	case MotionClip::Monocle:
+		_neck->moveMonocle(value, duration, axisCurve);
+		break;
+	case MotionClip::BodyRotate:
+		_body->rotateBody(value, duration);
+		break;
+	case MotionClip::BodyTiltForward:
+		_body->tiltBodyForward(value, duration);
+		break;
+	case MotionClip::BodyTiltSideways:
+		_body->tiltBodySideways(value, duration);
+		break;
+	case MotionClip::LeftEye:
+		_face->setLeftEyeTo(_face->getStateFrom(value));
+		break;
+	case MotionClip::RightEye:
+		_face->setRightEyeTo(_face->getStateFrom(value));
+		break;
+	case MotionClip::ChestLight:
+		_body->currentLightMode = (HuyangBody::LightMode)value;
+		break;
+	}
+}
+
+size_t HuyangSequencer::ClipFile::read(uint8_t *buffer, size_t size)
+{
+	return file.read(buffer, size);
+}
+
+bool HuyangSequencer::ClipFile::seek(uint32_t offset)
+{
+	return file.seek(offset);
+}
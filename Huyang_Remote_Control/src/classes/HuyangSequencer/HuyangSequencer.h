@@ -0,0 +1,73 @@
+#ifndef HuyangSequencer_h
+#define HuyangSequencer_h
+
+#include "Arduino.h"
+#include "FS.h"
+#include "LittleFS.h"
+#include "../MotionClock/MotionClock.h"
+#include "../MotionClip/MotionClip.h"
+#include "../HuyangNeck/HuyangNeck.h"
+#include "../HuyangBody/HuyangBody.h"
+#include "../HuyangFace/HuyangFace.h"
+
+#define HuyangSequencer_SEEK_TIME 500 // ms the axes take to reach the clip pose after a seek
+
+// Plays HYC2 keyframe clips (see MotionClip.h, made with tools/clipc) from LittleFS as the base layer of
+// neck, body and monocle, plus eye states and chest lights.
+// Only the next record is decoded ahead, the file is read further as the clip time reaches it,
+// so the length of a clip is only limited by the flash. The clip time is advanced by the control tick clock,
+// a clip plays the same way on every run.
+class HuyangSequencer
+{
+public:
+	HuyangSequencer(MotionClock *clock, HuyangNeck *neck, HuyangBody *body, HuyangFace *face);
+
+	// Starts a clip, speed in percent (100 = as authored). Returns false if the file is missing or broken.
+	bool play(const char *path, bool loop = false, uint16_t speed = 100);
+	void stop();
+	void setSpeed(uint16_t speed);
+	// Jumps to a clip time in ms, the axes move to the pose of that time
+	void seek(uint32_t time);
+	bool isPlaying();
+	// Calibration offsets added to the axis values of the clip, like the manual inputs get them.
+	// A change is picked up by the next record of each axis.
+	void setCalibration(int16_t neckRotate, int16_t neckTiltForward, int16_t neckTiltSideways, int16_t monocle,
+						int16_t bodyRotate, int16_t bodyTiltForward, int16_t bodyTiltSideways);
+
+	// Starts all records that are due, call once per control tick before the neck and body loops
+	void loop();
+
+private:
+	// LittleFS file as source of the clip decoder
+	class ClipFile : public MotionClip::Source
+	{
+	public:
+		File file;
+		size_t read(uint8_t *buffer, size_t size) override;
+		bool seek(uint32_t offset) override;
+	};
+
+	MotionClock *_clock;
+	HuyangNeck *_neck;
+	HuyangBody *_body;
+	HuyangFace *_face;
+
+	ClipFile _file;
+	MotionClip _clip;
+	MotionClip::Event _next; // Next record to start
+	bool _hasNext = false;
+	int16_t _calibration[MotionClip::LeftEye] = {0}; // Offset of every axis track
+
+	bool _playing = false;
+	bool _loop = false;
+	uint16_t _speed = 100;
+
+	uint32_t _clipTime = 0;  // Current position in the clip in ms
+	uint32_t _remainder = 0; // Part of a ms left over from the speed scaling
+	unsigned long _lastMillis = 0;
+
+	void startDueEvents();
+	void apply(uint8_t track, int16_t value, uint32_t duration, uint8_t curve);
+};
+
+#endif
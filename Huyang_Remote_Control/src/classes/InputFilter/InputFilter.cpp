@@ -0,0 +1,131 @@
+#include "InputFilter.h"
+
+// Low-pass factor in Q16 for a time step and a cutoff frequency (Q8 Hz): dt / (dt + tau), tau = 1 / (2 pi fc)
+static int32_t InputFilter_alpha(uint16_t dt, uint32_t cutoff)
+{
+	uint32_t tau = 40744UL / max(cutoff, (uint32_t)1); // ms, 1000 / (2 pi) in Q8
+	return (int32_t)(((uint32_t)dt << 16) / (dt + tau));
+}
+
+InputFilter::InputFilter()
+{
+	Settings settings = {1, 1, 256, 3277, 1000};
+	for (uint8_t input = 0; input < InputCount; input++)
+	{
+		configure(input, settings);
+		_raw[input] = 0;
+		_rawChangedAt[input] = 0;
+		_filtered[input] = 0;
+		_derivative[input] = 0;
+		_output[input] = 0;
+	}
+}
+
+void InputFilter::configure(uint8_t input, Settings settings)
+{
+	if (input >= InputCount)
+	{
+		return;
+	}
+
+	_deadband[input] = max(settings.deadband, (int16_t)0);
+	_hysteresis[input] = max(settings.hysteresis, (int16_t)0);
+	_minCutoff[input] = settings.minCutoff;
+	_beta[input] = settings.beta;
+	_restTime[input] = settings.restTime;
+}
+
+void InputFilter::tick(unsigned long now, uint16_t dt)
+{
+	_now = now;
+	_dt = max(dt, (uint16_t)1);
+}
+
+int16_t InputFilter::update(uint8_t input, int16_t raw)
+{
+	if (input >= InputCount)
+	{
+		return raw;
+	}
+
+	int32_t x = motionToQ8(raw);
+	bool rawChanged = raw != _raw[input];
+	if (rawChanged)
+	{
+		rawUpdates++;
+		if (_now - _rawChangedAt[input] >= _restTime[input])
+		{
+			// First change after a rest, nothing to smooth yet
+			_filtered[input] = x;
+			_derivative[input] = 0;
+		}
+		_raw[input] = raw;
+		_rawChangedAt[input] = _now;
+	}
+
+	// One Euro filter: the speed estimate raises the cutoff of the value filter
+	int32_t speed = (int32_t)(((int64_t)(x - _filtered[input]) * 1000) / _dt);
+	_derivative[input] += (int32_t)(((int64_t)(speed - _derivative[input]) * InputFilter_alpha(_dt, InputFilter_DERIVATIVE_CUTOFF)) >> 16);
+	uint32_t cutoff = _minCutoff[input] + (uint32_t)(((uint64_t)abs(_derivative[input]) * _beta[input]) >> 16);
+	_filtered[input] += (int32_t)(((int64_t)(x - _filtered[input]) * InputFilter_alpha(_dt, cutoff)) >> 16);
+
+	// Schmitt trigger between the filtered value and the last output. It only looks at new samples,
+	// so the output never changes more often than the raw input.
+	uint8_t bit = 1 << input;
+	int16_t output = _output[input];
+	int32_t distance = abs(_filtered[input] - motionToQ8(output));
+	int32_t threshold = motionToQ8(_deadband[input] + ((_followingMask & bit) ? 0 : _hysteresis[input]));
+	if (rawChanged && distance > threshold)
+	{
+		output = (int16_t)motionFromQ8(_filtered[input]);
+		_followingMask |= bit;
+	}
+	else if (_now - _rawChangedAt[input] >= InputFilter_SETTLE_TIME && abs(_filtered[input] - x) < InputFilter_SETTLED)
+	{
+		// The filter has arrived on a raw value that holds still: end exactly on it
+		_followingMask &= ~bit;
+		output = raw;
+	}
+	else if (rawChanged)
+	{
+		_followingMask &= ~bit;
+	}
+
+	if (output != _output[input])
+	{
+		_output[input] = output;
+		passedUpdates++;
+	}
+	else if (rawChanged)
+	{
+		suppressedUpdates++;
+	}
+	return output;
+}
+
+void InputFilter::set(uint8_t input, int16_t value)
+{
+	if (input >= InputCount)
+	{
+		return;
+	}
+
+	_raw[input] = value;
+	_rawChangedAt[input] = _now;
+	_filtered[input] = motionToQ8(value);
+	_derivative[input] = 0;
+	_output[input] = value;
+	_followingMask &= ~(1 << input);
+}
+
+int16_t InputFilter::value(uint8_t input)
+{
+	return input < InputCount ? _output[input] : 0;
+}
+
+void InputFilter::resetCounters()
+{
+	rawUpdates = 0;
+	suppressedUpdates = 0;
+	passedUpdates = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef InputFilter_h
+#define InputFilter_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+
+#define InputFilter_DERIVATIVE_CUTOFF 256 // Q8 Hz, cutoff of the speed estimate (1 Hz as in the One Euro paper)
+#define InputFilter_SETTLED 64            // Q8, the filter is on its input when it is closer than a quarter unit
+#define InputFilter_SETTLE_TIME 100       // ms an input has to hold still before the output snaps onto it
+
+// Conditioning of the manual inputs from the web interface before they reach the motion engine.
+// Every input runs through a One Euro filter: a low-pass whose cutoff rises with the speed of the input,
+// so a resting joystick is smoothed hard and a fast one follows with little lag. A Schmitt trigger then
+// decides if the filtered value is far enough from the last output to become a new target: deadband while
+// the output is following, deadband + hysteresis to start following again from rest.
+// An input that was still for restTime ms jumps straight to a new value, single slider clicks are not delayed.
+// All values are fixed point (Q8 input units), one array per field like MotionAxis.
+class InputFilter
+{
+public:
+	enum Input
+	{
+		NeckRotate = 0,
+		NeckTiltForward = 1,
+		NeckTiltSideways = 2,
+		Monocle = 3,
+		BodyRotate = 4,
+		BodyTiltForward = 5,
+		BodyTiltSideways = 6,
+		InputCount = 7
+	};
+
+	struct Settings
+	{
+		int16_t deadband;   // Input units the filtered value has to move before the output follows
+		int16_t hysteresis; // Extra units needed to start following from rest
+		uint16_t minCutoff; // Q8 Hz, cutoff of a resting input, lower = smoother
+		uint16_t beta;      // Q16 Hz per input unit/s, how fast the cutoff rises with the speed
+		uint16_t restTime;  // ms without change after which a new value is passed through unfiltered
+	};
+
+	InputFilter();
+
+	void configure(uint8_t input, Settings settings);
+	// Starts a control tick, dt is the time since the last one in ms
+	void tick(unsigned long now, uint16_t dt);
+	// Feeds the raw value of this tick and returns the conditioned value
+	int16_t update(uint8_t input, int16_t raw);
+	// Puts an input on a value without filtering, for targets that are no jitter (pose recall)
+	void set(uint8_t input, int16_t value);
+	int16_t value(uint8_t input);
+
+	// Counters over all inputs
+	uint32_t rawUpdates = 0;        // Ticks in which a raw value changed
+	uint32_t suppressedUpdates = 0; // Raw changes that did not change the output
+	uint32_t passedUpdates = 0;     // Output changes handed to the motion engine
+	void resetCounters();
+
+private:
+	unsigned long _now = 0;
+	uint16_t _dt = 1;
+
+	// Settings
+	int16_t _deadband[InputCount];
+	int16_t _hysteresis[InputCount];
+	uint16_t _minCutoff[InputCount];
+	uint16_t _beta[InputCount];
+	uint16_t _restTime[InputCount];
+
+	// State
+	int16_t _raw[InputCount];
+	unsigned long _rawChangedAt[InputCount];
+	int32_t _filtered[InputCount];   // Q8
+	int32_t _derivative[InputCount]; // Q8 units per second
+	int16_t _output[InputCount];
+	uint8_t _followingMask = 0;      // Bit set = output follows the filter
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "InputPlayout.h"
+
+void InputPlayout::push(uint32_t sequence, uint32_t clientTime, unsigned long arrival, const int16_t *values)
+{
+	int32_t offset = (int32_t)(arrival - clientTime);
+
+	// A pause or a new client starts a new stream with its own clock offset
+	if (_active == false || arrival - _lastArrival > InputPlayout_TIMEOUT || (int32_t)(clientTime - _lastClientTime) < -InputPlayout_TIMEOUT)
+	{
+		reset(offset);
+		_lastUpdate = arrival;
+	}
+	else if ((int32_t)(sequence - _lastSequence) <= 0)
+	{
+		outOfOrderPackets++;
+		return;
+	}
+	else
+	{
+		// Transit time difference to the previous packet, smoothed by 1/16
+		int32_t transit = (int32_t)(arrival - _lastArrival) - (int32_t)(clientTime - _lastClientTime);
+		_jitterQ4 = _jitterQ4 - _jitterQ4 / 16 + (uint32_t)abs(transit);
+
+		// Packet interval smoothed by 1/8, the reach of the extrapolation
+		int32_t intervalQ4 = (int32_t)(clientTime - _lastClientTime) << 4;
+		_intervalQ4 = _intervalQ4 == 0 ? intervalQ4 : _intervalQ4 + (intervalQ4 - _intervalQ4) / 8;
+
+		// The offset follows faster packets at once and drifts up slowly, so clock drift is followed too
+		if (offset < _offset)
+		{
+			_offset = offset;
+		}
+		else
+		{
+			_offset += (offset - _offset + 63) / 64;
+		}
+
+		if ((int32_t)(clientTime - _playTime) < 0)
+		{
+			latePackets++;
+		}
+	}
+
+	packets++;
+	_lastSequence = sequence;
+	_lastClientTime = clientTime;
+	_lastArrival = arrival;
+
+	if (_count == InputPlayout_SAMPLES)
+	{
+		pop();
+	}
+	uint8_t slot = (_first + _count) % InputPlayout_SAMPLES;
+	_time[slot] = clientTime;
+	for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+	{
+		_values[slot][i] = values[i];
+	}
+	_count++;
+}
+
+bool InputPlayout::update(unsigned long now)
+{
+	if (_active == false || _count == 0)
+	{
+		return false;
+	}
+
+	// Stream ended: stay on the last packet
+	if (now - _lastArrival > InputPlayout_TIMEOUT)
+	{
+		uint8_t last = (_first + _count - 1) % InputPlayout_SAMPLES;
+		for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+		{
+			_output[i] = _values[last][i];
+		}
+		_active = false;
+		return true;
+	}
+
+	// The delay moves 1 ms per InputPlayout_DELAY_SLEW ms towards its target, at any tick rate, the playout never jumps
+	int32_t target = constrain(_jitterQ4 * InputPlayout_JITTER_FACTOR, (uint32_t)InputPlayout_MIN_DELAY << 4, (uint32_t)InputPlayout_MAX_DELAY << 4);
+	int32_t slew = min(now - _lastUpdate, (unsigned long)InputPlayout_TIMEOUT) * 16 / InputPlayout_DELAY_SLEW;
+	_lastUpdate = now;
+	_delayQ4 += constrain(target - (int32_t)_delayQ4, -slew, slew);
+
+	_playTime = (uint32_t)(now - _offset - (_delayQ4 >> 4));
+
+	// Drop packets that are behind the playout, the last one dropped is kept for extrapolation
+	while (_count >= 2 && (int32_t)(_playTime - _time[(_first + 1) % InputPlayout_SAMPLES]) >= 0)
+	{
+		pop();
+	}
+
+	uint32_t t0 = _time[_first];
+	if ((int32_t)(_playTime - t0) <= 0)
+	{
+		// Before the first packet: hold it
+		for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+		{
+			_output[i] = _values[_first][i];
+		}
+	}
+	else if (_count >= 2)
+	{
+		// Between two packets
+		uint8_t next = (_first + 1) % InputPlayout_SAMPLES;
+		int32_t span = max((int32_t)(_time[next] - t0), (int32_t)1);
+		int32_t elapsed = (int32_t)(_playTime - t0);
+		for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+		{
+			_output[i] = _values[_first][i] + (int16_t)(((int32_t)(_values[next][i] - _values[_first][i]) * elapsed) / span);
+		}
+	}
+	else if (_hasPrevious)
+	{
+		// Ahead of the newest packet: continue its last step for up to one packet interval, then glide back
+		int32_t span = max((int32_t)(t0 - _previousTime), (int32_t)1);
+		int32_t reach = min((int32_t)(_intervalQ4 >> 4), (int32_t)InputPlayout_MAX_EXTRAPOLATION);
+		int32_t elapsed = (int32_t)(_playTime - t0);
+		int32_t ahead = elapsed <= reach ? elapsed : max(2 * reach - elapsed, (int32_t)0);
+		for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+		{
+			int32_t value = _values[_first][i] + ((int32_t)(_values[_first][i] - _previousValues[i]) * ahead) / span;
+			_output[i] = (int16_t)constrain(value, (int32_t)-InputPlayout_LIMIT, (int32_t)InputPlayout_LIMIT);
+		}
+		if (ahead > 0)
+		{
+			extrapolatedTicks++;
+		}
+	}
+	else
+	{
+		for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+		{
+			_output[i] = _values[_first][i];
+		}
+	}
+	return true;
+}
+
+int16_t InputPlayout::value(uint8_t index)
+{
+	return index < InputPlayout_VALUES ? _output[index] : 0;
+}
+
+bool InputPlayout::isActive()
+{
+	return _active;
+}
+
+uint16_t InputPlayout::jitter()
+{
+	return (uint16_t)(_jitterQ4 >> 4);
+}
+
+uint16_t InputPlayout::delay()
+{
+	return (uint16_t)(_delayQ4 >> 4);
+}
+
+void InputPlayout::resetCounters()
+{
+	packets = 0;
+	latePackets = 0;
+	outOfOrderPackets = 0;
+	extrapolatedTicks = 0;
+}
+
+void InputPlayout::reset(int32_t offset)
+{
+	_first = 0;
+	_count = 0;
+	_hasPrevious = false;
+	_offset = offset;
+	_jitterQ4 = 0;
+	_intervalQ4 = 0;
+	_delayQ4 = InputPlayout_MIN_DELAY << 4;
+	_playTime = 0;
+	_active = true;
+}
+
+void InputPlayout::pop()
+{
+	_previousTime = _time[_first];
+	for (uint8_t i = 0; i < InputPlayout_VALUES; i++)
+	{
+		_previousValues[i] = _values[_first][i];
+	}
+	_hasPrevious = true;
+	_first = (_first + 1) % InputPlayout_SAMPLES;
+	_count--;
+}
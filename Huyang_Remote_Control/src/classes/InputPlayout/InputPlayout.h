@@ -0,0 +1,75 @@
+#ifndef InputPlayout_h
+#define InputPlayout_h
+
+#include "Arduino.h"
+
+#define InputPlayout_SAMPLES 8            // Buffered packets, more than the longest playout delay holds
+#define InputPlayout_VALUES 3             // Values per packet (rotate, tilt forward, tilt sideways)
+#define InputPlayout_LIMIT 100            // Values are slider units, extrapolation stays within +-100
+#define InputPlayout_MIN_DELAY 20         // ms, playout delay on a clean connection
+#define InputPlayout_MAX_DELAY 250        // ms, more would feel like lag
+#define InputPlayout_JITTER_FACTOR 3      // Playout delay = this many times the measured jitter
+#define InputPlayout_DELAY_SLEW 16        // ms of time per ms the delay moves, the playout runs at 15/16 to 17/16 speed
+#define InputPlayout_MAX_EXTRAPOLATION 100 // ms a gap is bridged by extrapolation
+#define InputPlayout_TIMEOUT 500          // ms without a packet end the stream
+
+// Playout buffer for joystick packets streamed over Wi-Fi.
+// The client stamps every packet with a sequence number and its own time in ms. Packets are
+// replayed on the client's timeline, shifted by a playout delay: every control tick interpolates
+// between the two packets around the playout time, so the servos follow the path the joystick
+// took instead of the times the packets happened to land. A gap is bridged by extrapolating
+// for up to one packet interval, then the value glides back to the last packet.
+//
+// The clock offset follows the fastest packet, the jitter is the smoothed difference of
+// transit times between packets (RFC 3550) and the delay adapts to a multiple of it.
+class InputPlayout
+{
+public:
+	// Stores a packet, called by the web server. arrival is MotionClock::now() when it came in.
+	void push(uint32_t sequence, uint32_t clientTime, unsigned long arrival, const int16_t *values);
+	// Moves the playout to now (MotionClock::now(), the clock of the arrivals), false while no stream is active
+	bool update(unsigned long now);
+	int16_t value(uint8_t index);
+	bool isActive();
+
+	uint16_t jitter(); // ms
+	uint16_t delay();  // ms
+
+	// Counters, reset with resetCounters()
+	uint32_t packets = 0;
+	uint32_t latePackets = 0;       // Arrived after their time was played already
+	uint32_t outOfOrderPackets = 0; // Sequence number not newer than the last one, dropped
+	uint32_t extrapolatedTicks = 0; // Ticks that ran ahead of the newest packet
+	void resetCounters();
+
+private:
+	// Ring buffer of packets, oldest first
+	uint32_t _time[InputPlayout_SAMPLES]; // Client time
+	int16_t _values[InputPlayout_SAMPLES][InputPlayout_VALUES];
+	uint8_t _first = 0;
+	uint8_t _count = 0;
+
+	// Packet before _first, the start of the extrapolation
+	uint32_t _previousTime = 0;
+	int16_t _previousValues[InputPlayout_VALUES];
+	bool _hasPrevious = false;
+
+	bool _active = false;
+	uint32_t _lastSequence = 0;
+	uint32_t _lastClientTime = 0;
+	unsigned long _lastArrival = 0;
+
+	int32_t _offset = 0;        // Local time - client time of the fastest packet
+	uint32_t _jitterQ4 = 0;     // ms, Q4
+	int32_t _intervalQ4 = 0;    // ms between packets, Q4
+	uint32_t _delayQ4 = InputPlayout_MIN_DELAY << 4; // ms, Q4
+	unsigned long _lastUpdate = 0;
+	uint32_t _playTime = 0;     // Client time played at the last update()
+
+	int16_t _output[InputPlayout_VALUES];
+
+	void reset(int32_t offset);
+	void pop();
+};
+
+#endif
@@ -0,0 +1,844 @@
+#include "MotionAxis.h"
+
+MotionAxis::MotionAxis(PwmBus *bus)
+{
+	_bus = bus;
+	setTickRate(60);
+}
+
+uint8_t MotionAxis::addAxis(int32_t position, uint8_t channel)
+{
+	if (_count >= MotionAxis_MAX_AXES)
+	{
+		Serial.println("MotionAxis: no free axis left, increase MotionAxis_MAX_AXES");
+		return MotionAxis_NO_AXIS;
+	}
+
+	uint8_t axis = _count++;
+
+	_start[axis] = position;
+	_target[axis] = position;
+	_position[axis] = position;
+	_startMillis[axis] = 0;
+	_duration[axis] = 0;
+	_curve[axis] = EaseInOutQuad;
+	_channel[axis] = channel;
+	_plan[axis] = MotionAxis_NO_PLAN;
+	_output[axis] = position;
+	_estimate[axis] = position;
+	_delta[axis] = 0;
+	_queue[axis] = MotionAxis_NO_QUEUE;
+	_outputMin[axis] = INT32_MIN;
+	_outputMax[axis] = INT32_MAX;
+	for (uint8_t layer = 0; layer < MotionAxis_LAYERS; layer++)
+	{
+		_layer[axis][layer] = MotionAxis_NO_AXIS;
+	}
+
+	return axis;
+}
+
+uint8_t MotionAxis::addLayer(uint8_t axis, Layer layer)
+{
+	uint8_t offset = addAxis(0);
+	if (offset == MotionAxis_NO_AXIS)
+	{
+		return MotionAxis_NO_AXIS;
+	}
+	_layer[axis][layer] = offset;
+	_layeredMask |= (uint32_t)1 << axis;
+	return offset;
+}
+
+void MotionAxis::setLayerWeight(Layer layer, uint16_t weight)
+{
+	_layerWeightTarget[layer] = min(weight, (uint16_t)MotionAxis_WEIGHT_ONE);
+}
+
+void MotionAxis::setOutputRange(uint8_t axis, int32_t min, int32_t max)
+{
+	_outputMin[axis] = min;
+	_outputMax[axis] = max;
+}
+
+void MotionAxis::moveTo(uint8_t axis, int32_t target, uint16_t duration, Curve curve)
+{
+	if (_collecting)
+	{
+		_jobTarget[axis] = target;
+		_jobMask |= (uint32_t)1 << axis;
+		return;
+	}
+
+	if (_target[axis] == target && queueDepth(axis) == 0) // Only update if target has changed
+	{
+		return;
+	}
+
+	startMove(axis, target, duration, curve);
+
+	uint8_t slot = _plan[axis];
+	if (slot != MotionAxis_NO_PLAN)
+	{
+		// The planner keeps its velocity, only the cruise speed follows the requested duration
+		_cruiseVelocity[slot] = _maxVelocity[slot];
+		_acceleration[slot] = _maxAcceleration[slot];
+		if (duration > 0)
+		{
+			int32_t way = abs(target - _planPosition[slot]);
+			int32_t velocity = (int32_t)((int64_t)way * 1000 / duration);
+			_cruiseVelocity[slot] = constrain(velocity, 1, _maxVelocity[slot]);
+		}
+	}
+}
+
+void MotionAxis::startMove(uint8_t axis, int32_t target, uint16_t duration, Curve curve)
+{
+	_start[axis] = _position[axis];
+	_target[axis] = target;
+	_duration[axis] = duration;
+	_curve[axis] = curve;
+	_startMillis[axis] = _currentMillis;
+	_movingMask |= (uint32_t)1 << axis;
+
+	// A direct move replaces whatever was streamed
+	_queuedMask &= ~((uint32_t)1 << axis);
+	if (_queue[axis] != MotionAxis_NO_QUEUE)
+	{
+		_queueLength[_queue[axis]] = 0;
+	}
+}
+
+void MotionAxis::beginMove()
+{
+	_collecting = true;
+	_jobMask = 0;
+}
+
+bool MotionAxis::commitMove(uint16_t duration, Curve curve)
+{
+	_collecting = false;
+
+	// Drop axes that are already heading to their collected target
+	uint32_t job = 0;
+	for (uint8_t axis = 0; axis < _count; axis++)
+	{
+		if ((_jobMask & ((uint32_t)1 << axis)) != 0 && _jobTarget[axis] != _target[axis])
+		{
+			job |= (uint32_t)1 << axis;
+		}
+	}
+	_jobMask = 0;
+
+	if (job == 0)
+	{
+		return false;
+	}
+
+	// Planned axes run one common profile scaled to their way: velocity and acceleration as Q16 fraction
+	// of the way per second. The axis with the least headroom for its way limits everybody.
+	int64_t velocity = INT64_MAX;
+	int64_t acceleration = INT64_MAX;
+	for (uint8_t axis = 0; axis < _count; axis++)
+	{
+		uint8_t slot = _plan[axis];
+		if ((job & ((uint32_t)1 << axis)) == 0 || slot == MotionAxis_NO_PLAN)
+		{
+			continue;
+		}
+		int64_t way = abs(_jobTarget[axis] - _planPosition[slot]);
+		if (way == 0)
+		{
+			continue;
+		}
+		velocity = min(velocity, (int64_t)_maxVelocity[slot] * MotionMath_ONE / way);
+		acceleration = min(acceleration, (int64_t)_maxAcceleration[slot] * MotionMath_ONE / way);
+	}
+
+	// Timed axes get at least the time their servo needs at the peak velocity of the curve
+	uint32_t jobDuration = duration;
+	uint32_t modeled = job & _modelMask;
+	for (uint8_t axis = 0; modeled != 0; axis++, modeled >>= 1)
+	{
+		if ((modeled & 1) != 0 && _plan[axis] == MotionAxis_NO_PLAN)
+		{
+			uint32_t way = abs(_jobTarget[axis] - _position[axis]);
+			jobDuration = max(jobDuration, (uint32_t)((uint64_t)way * 1000 * MotionAxis_CURVE_PEAK / _modelVelocity[axis]));
+		}
+	}
+	uint32_t timedDuration = jobDuration;
+	uint32_t scale = MotionMath_ONE; // Q16 time scale of the planned profile, 1.0 = as fast as allowed
+	if (velocity != INT64_MAX)
+	{
+		// Short ways never reach the cruise velocity, the profile is a triangle then
+		velocity = max(min(velocity, (int64_t)motionSqrt((uint64_t)acceleration * MotionMath_ONE)), (int64_t)1);
+		acceleration = max(acceleration, (int64_t)1);
+
+		// Duration of the trapezoid for a way of 1.0
+		uint32_t fastest = (uint32_t)(1000LL * MotionMath_ONE / velocity + 1000LL * velocity / acceleration);
+		if (fastest > jobDuration)
+		{
+			jobDuration = fastest;
+		}
+		// Stretching the time by 1/scale needs velocity * scale and acceleration * scale²
+		scale = (uint32_t)(((uint64_t)fastest << 16) / jobDuration);
+
+		// Planned axes settle after their trapezoid once the moving average has caught up, the timed axes wait for that
+		timedDuration = jobDuration + _smoothingDelay;
+	}
+	timedDuration = min(timedDuration, (uint32_t)UINT16_MAX);
+
+	for (uint8_t axis = 0; axis < _count; axis++)
+	{
+		if ((job & ((uint32_t)1 << axis)) == 0)
+		{
+			continue;
+		}
+
+		uint8_t slot = _plan[axis];
+		if (slot != MotionAxis_NO_PLAN)
+		{
+			int64_t way = abs(_jobTarget[axis] - _planPosition[slot]);
+			int64_t axisVelocity = (velocity * scale >> 16) * way >> 16;
+			int64_t axisAcceleration = ((acceleration * scale >> 16) * scale >> 16) * way >> 16;
+			_cruiseVelocity[slot] = constrain(axisVelocity, 1, _maxVelocity[slot]);
+			_acceleration[slot] = constrain(axisAcceleration, 1, _maxAcceleration[slot]);
+		}
+		startMove(axis, _jobTarget[axis], timedDuration, curve);
+	}
+	return true;
+}
+
+void MotionAxis::enableQueue(uint8_t axis)
+{
+	if (_queue[axis] != MotionAxis_NO_QUEUE)
+	{
+		return;
+	}
+	if (_queueCount >= MotionAxis_MAX_QUEUED)
+	{
+		Serial.println("MotionAxis: no free queue left, increase MotionAxis_MAX_QUEUED");
+		return;
+	}
+
+	uint8_t slot = _queueCount++;
+	_queue[axis] = slot;
+	_queueHead[slot] = 0;
+	_queueLength[slot] = 0;
+	_tangentStart[slot] = 0;
+	_tangentEnd[slot] = 0;
+}
+
+bool MotionAxis::queueTo(uint8_t axis, int32_t target, uint16_t duration)
+{
+	uint8_t slot = _queue[axis];
+	if (slot == MotionAxis_NO_QUEUE || _plan[axis] != MotionAxis_NO_PLAN)
+	{
+		if (_target[axis] == target)
+		{
+			return false;
+		}
+		moveTo(axis, target, duration);
+		return true;
+	}
+
+	// Compare with the last target the axis was given, queued or not
+	uint8_t length = _queueLength[slot];
+	int32_t last = length > 0 ? _queueTarget[slot][(_queueHead[slot] + length - 1) % MotionAxis_QUEUE_SIZE] : _target[axis];
+	if (last == target)
+	{
+		return false;
+	}
+
+	// A full queue drops its oldest waiting command, the newest input matters most
+	bool nextChanged = length == 0;
+	if (length >= MotionAxis_QUEUE_SIZE)
+	{
+		_queueHead[slot] = (_queueHead[slot] + 1) % MotionAxis_QUEUE_SIZE;
+		length--;
+		droppedCommands++;
+		nextChanged = true;
+	}
+
+	uint8_t index = (_queueHead[slot] + length) % MotionAxis_QUEUE_SIZE;
+	_queueTarget[slot][index] = target;
+	_queueDuration[slot][index] = max(duration, (uint16_t)1);
+	_queueLength[slot] = length + 1;
+
+	queuedCommands++;
+	queuePeak = max(queuePeak, _queueLength[slot]);
+
+	// The running segment has to know where the stream goes next
+	if (nextChanged)
+	{
+		blendSegment(axis, slot, duration);
+	}
+	return true;
+}
+
+bool MotionAxis::queueMove(uint16_t duration)
+{
+	_collecting = false;
+
+	bool queued = false;
+	for (uint8_t axis = 0; axis < _count; axis++)
+	{
+		if ((_jobMask & ((uint32_t)1 << axis)) != 0 && queueTo(axis, _jobTarget[axis], duration))
+		{
+			queued = true;
+		}
+	}
+	_jobMask = 0;
+	return queued;
+}
+
+// Ending velocity of a segment: with a waiting command the average of the slopes before and after the target,
+// limited to three times the smaller slope so the segment cannot swing past its target (Fritsch-Carlson).
+// A change of direction or an empty queue ends the segment at rest.
+int32_t MotionAxis::segmentTangent(uint8_t slot, int32_t start, int32_t target, uint16_t duration)
+{
+	if (_queueLength[slot] == 0)
+	{
+		return 0;
+	}
+
+	uint8_t head = _queueHead[slot];
+	int64_t slopeBefore = (int64_t)(target - start) * 1000 / duration;
+	int64_t slopeAfter = (int64_t)(_queueTarget[slot][head] - target) * 1000 / _queueDuration[slot][head];
+	if (slopeBefore == 0 || slopeAfter == 0 || (slopeBefore < 0) != (slopeAfter < 0))
+	{
+		return 0;
+	}
+
+	int64_t velocity = (slopeBefore + slopeAfter) / 2;
+	int64_t limit = 3 * min(abs(slopeBefore), abs(slopeAfter));
+	velocity = constrain(velocity, -limit, limit);
+	return (int32_t)(velocity * duration / 1000);
+}
+
+// Takes the next command from the queue as new segment, starting at the current position with velocity (units per second)
+void MotionAxis::startSegment(uint8_t axis, uint8_t slot, int32_t velocity)
+{
+	uint8_t head = _queueHead[slot];
+	int32_t target = _queueTarget[slot][head];
+	uint16_t duration = _queueDuration[slot][head];
+	_queueHead[slot] = (head + 1) % MotionAxis_QUEUE_SIZE;
+	_queueLength[slot]--;
+
+	_start[axis] = _position[axis];
+	_target[axis] = target;
+	_duration[axis] = duration;
+	_tangentStart[slot] = (int32_t)((int64_t)velocity * duration / 1000);
+	_tangentEnd[slot] = segmentTangent(slot, _start[axis], target, duration);
+	_queuedMask |= (uint32_t)1 << axis;
+	_movingMask |= (uint32_t)1 << axis;
+}
+
+// Restarts the running move from the current position and velocity towards its old target, now with the
+// next command in view. A resting axis starts the next command right away.
+void MotionAxis::blendSegment(uint8_t axis, uint8_t slot, uint16_t duration)
+{
+	if (isMoving(axis) == false)
+	{
+		_startMillis[axis] = _currentMillis;
+		startSegment(axis, slot, 0);
+		return;
+	}
+
+	uint32_t elapsed = _currentMillis - _startMillis[axis];
+	if (elapsed >= _duration[axis])
+	{
+		return; // Ends with this tick, the next one picks up the queue
+	}
+
+	// A queued segment knows its exact velocity, any other move is measured over the last tick
+	int32_t current = velocity(axis);
+	if ((_queuedMask & ((uint32_t)1 << axis)) != 0)
+	{
+		int32_t s = motionProgress(elapsed, _duration[axis]);
+		int32_t s2 = (int32_t)((int64_t)s * s >> 16);
+		int64_t slope = (int64_t)(_target[axis] - _start[axis]) * (6 * s - 6 * s2) + (int64_t)_tangentStart[slot] * (3 * s2 - 4 * s + MotionMath_ONE) + (int64_t)_tangentEnd[slot] * (3 * s2 - 2 * s);
+		current = (int32_t)((slope >> 16) * 1000 / _duration[axis]);
+	}
+
+	// At most the new duration left, but never less than a tick so the blend has room to bend
+	uint32_t remaining = min((uint32_t)duration, _duration[axis] - elapsed);
+	remaining = max(remaining, (uint32_t)max(_step, (int32_t)1));
+	_start[axis] = _position[axis];
+	_duration[axis] = remaining;
+	_startMillis[axis] = _currentMillis;
+	_tangentStart[slot] = (int32_t)((int64_t)current * _duration[axis] / 1000);
+	_tangentEnd[slot] = segmentTangent(slot, _start[axis], _target[axis], _duration[axis]);
+	_queuedMask |= (uint32_t)1 << axis;
+}
+
+// Moves a queued axis along its cubic Hermite segment, returns true once it rests on the last target
+bool MotionAxis::followQueue(uint8_t axis, uint8_t slot, unsigned long now)
+{
+	uint32_t elapsed = now - _startMillis[axis];
+	while (elapsed >= _duration[axis])
+	{
+		_position[axis] = _target[axis];
+		if (_queueLength[slot] == 0)
+		{
+			return true;
+		}
+
+		// The next segment starts where this one ended, the time left over is not lost
+		int32_t velocity = (int32_t)((int64_t)_tangentEnd[slot] * 1000 / _duration[axis]);
+		_startMillis[axis] += _duration[axis];
+		elapsed -= _duration[axis];
+		startSegment(axis, slot, velocity);
+	}
+
+	int32_t s = motionProgress(elapsed, _duration[axis]);
+	int32_t s2 = (int32_t)((int64_t)s * s >> 16);
+	int32_t s3 = (int32_t)((int64_t)s2 * s >> 16);
+
+	// Hermite basis: position weight of the target and the two tangents
+	int32_t toTarget = 3 * s2 - 2 * s3;
+	int32_t fromStart = s3 - 2 * s2 + s;
+	int32_t intoTarget = s3 - s2;
+
+	int64_t way = (int64_t)(_target[axis] - _start[axis]) * toTarget + (int64_t)_tangentStart[slot] * fromStart + (int64_t)_tangentEnd[slot] * intoTarget;
+	_position[axis] = _start[axis] + (int32_t)(way >> 16);
+	return false;
+}
+
+void MotionAxis::setPosition(uint8_t axis, int32_t position)
+{
+	_start[axis] = position;
+	_target[axis] = position;
+	_position[axis] = position;
+	_output[axis] = position;
+	_duration[axis] = 0;
+	_movingMask |= (uint32_t)1 << axis; // Let the next tick write it to the servo
+	_queuedMask &= ~((uint32_t)1 << axis);
+	if (_queue[axis] != MotionAxis_NO_QUEUE)
+	{
+		_queueLength[_queue[axis]] = 0;
+	}
+
+	if (_plan[axis] != MotionAxis_NO_PLAN)
+	{
+		resetPlan(_plan[axis], position);
+	}
+}
+
+void MotionAxis::setLimits(uint8_t axis, int32_t maxVelocity, int32_t maxAcceleration)
+{
+	uint8_t slot = _plan[axis];
+	if (slot == MotionAxis_NO_PLAN)
+	{
+		if (_planCount >= MotionAxis_MAX_PLANNED)
+		{
+			Serial.println("MotionAxis: no free planner slot left, increase MotionAxis_MAX_PLANNED");
+			return;
+		}
+		slot = _planCount++;
+		_plan[axis] = slot;
+		resetPlan(slot, _position[axis]);
+	}
+
+	_maxVelocity[slot] = max(maxVelocity, (int32_t)1);
+	_maxAcceleration[slot] = max(maxAcceleration, (int32_t)1);
+	_cruiseVelocity[slot] = _maxVelocity[slot];
+	_acceleration[slot] = _maxAcceleration[slot];
+}
+
+void MotionAxis::resetPlan(uint8_t slot, int32_t position)
+{
+	_planPosition[slot] = position;
+	_velocity[slot] = 0;
+	_residual[slot] = 0;
+	for (uint8_t i = 0; i < MotionAxis_MAX_SMOOTHING; i++)
+	{
+		_smoothing[slot][i] = position;
+	}
+	_smoothingSum[slot] = position * _smoothingLength;
+}
+
+// One planner step of dt milliseconds, returns true once the axis rests on its target.
+// Constant cost: the trapezoid decides between accelerate, cruise and brake from the current state only,
+// so a new target simply changes the decision of the next step.
+bool MotionAxis::plan(uint8_t axis, uint8_t slot, int32_t dt)
+{
+	int32_t position = _planPosition[slot];
+	int32_t velocity = _velocity[slot];
+	int32_t acceleration = _acceleration[slot];
+	int32_t distance = _target[axis] - position;
+	// On the target but still moving counts as moving towards it, so the step brakes
+	int32_t direction = distance < 0 || (distance == 0 && velocity < 0) ? -1 : 1;
+
+	if (distance != 0 || velocity != 0)
+	{
+		int32_t command;
+		int32_t speed = abs(velocity);
+		bool towards = velocity != 0 && (velocity < 0) == (direction < 0);
+
+		if (towards)
+		{
+			// Moving towards the target: brake when the remaining way (minus this step) is the stopping distance.
+			// The ways are in unit-milliseconds, slow steps of less than a unit count as well.
+			int64_t room = (int64_t)abs(distance) * 1000 - (int64_t)speed * dt;
+			if (room < 0)
+			{
+				room = 0;
+			}
+			int64_t speedSquared = (int64_t)speed * speed;
+
+			if (speedSquared * 1000 >= 2 * (int64_t)acceleration * room)
+			{
+				// Deceleration that stops exactly on the target
+				int64_t needed = distance != 0 ? (speedSquared + 2 * abs(distance) - 1) / (2 * (int64_t)abs(distance)) : acceleration;
+				command = -direction * (int32_t)min(needed, (int64_t)acceleration);
+			}
+			else if (speed > _cruiseVelocity[slot])
+			{
+				command = -direction * acceleration;
+			}
+			else
+			{
+				// Only speed up if the faster step still leaves the way to stop from the higher speed,
+				// otherwise hold the speed and brake in one of the next steps
+				int32_t faster = min(speed + (int32_t)((int64_t)acceleration * dt / 1000), _cruiseVelocity[slot]);
+				int64_t fasterRoom = (int64_t)abs(distance) * 2000 - (int64_t)(speed + faster) * dt;
+				if ((int64_t)faster * faster * 1000 <= (int64_t)acceleration * fasterRoom)
+				{
+					command = direction * acceleration;
+				}
+				else
+				{
+					command = 0;
+				}
+			}
+		}
+		else
+		{
+			// Standing or moving away from the target: turn around
+			command = direction * acceleration;
+		}
+
+		int32_t change = (int32_t)((int64_t)command * dt / 1000);
+		if ((int64_t)command * velocity < 0)
+		{
+			// Braking rounds up, otherwise the truncated steps add up to a stop behind the target.
+			// A brake towards the target ends at standstill, it does not turn around within the step.
+			int32_t limit = (int32_t)((int64_t)acceleration * dt / 1000);
+			int32_t rounded = (int32_t)min(((int64_t)abs(command) * dt + 999) / 1000, (int64_t)limit);
+			if (towards)
+			{
+				rounded = min(rounded, speed);
+			}
+			change = command < 0 ? -rounded : rounded;
+		}
+		int32_t newVelocity = velocity + change;
+		if (command * direction > 0 && newVelocity * direction > _cruiseVelocity[slot])
+		{
+			newVelocity = direction * _cruiseVelocity[slot];
+		}
+
+		// Trapezoidal integration, the remainder is carried to the next step
+		int32_t step = (velocity + newVelocity) / 2 * dt + _residual[slot];
+		position += step / 1000;
+		_residual[slot] = step % 1000;
+
+		// Arrived when the target is reached or passed at a speed this step can stop from,
+		// so stopping is no larger a velocity change than any other step
+		int32_t remaining = _target[axis] - position;
+		if ((int64_t)remaining * direction <= 0 && abs(velocity) <= (int32_t)((int64_t)acceleration * dt / 1000))
+		{
+			position = _target[axis];
+			newVelocity = 0;
+			_residual[slot] = 0;
+		}
+		velocity = newVelocity;
+
+		_planPosition[slot] = position;
+		_velocity[slot] = velocity;
+	}
+
+	// Moving average over the last ticks limits the jerk of the trapezoid corners
+	int32_t *history = _smoothing[slot];
+	_smoothingSum[slot] += position - history[_smoothingIndex];
+	history[_smoothingIndex] = position;
+	_position[axis] = _smoothingSum[slot] / _smoothingLength;
+
+	if (velocity == 0 && position == _target[axis])
+	{
+		// Done when the average has caught up as well
+		for (uint8_t i = 0; i < _smoothingLength; i++)
+		{
+			if (history[i] != position)
+			{
+				return false;
+			}
+		}
+		_position[axis] = position;
+		return true;
+	}
+	return false;
+}
+
+int32_t MotionAxis::ease(uint8_t curve, uint32_t progress)
+{
+	switch (curve)
+	{
+	case Linear:
+		return progress;
+	case EaseInOutQuad:
+		return motionEaseInOutQuad(progress);
+	default:
+		return motionCurve(curve - EaseInOutCubic, progress);
+	}
+}
+
+void MotionAxis::setTickRate(uint16_t tickRate)
+{
+	tickRate = max(tickRate, (uint16_t)1);
+	uint32_t length = ((uint32_t)MotionAxis_SMOOTHING_MILLIS * tickRate + 500) / 1000;
+	_smoothingLength = constrain(length, (uint32_t)1, (uint32_t)MotionAxis_MAX_SMOOTHING);
+	_smoothingDelay = (_smoothingLength - 1) * 1000 / tickRate;
+	_smoothingIndex = 0;
+
+	// The averages restart from where each planner is
+	for (uint8_t slot = 0; slot < _planCount; slot++)
+	{
+		int32_t position = _planPosition[slot];
+		for (uint8_t i = 0; i < MotionAxis_MAX_SMOOTHING; i++)
+		{
+			_smoothing[slot][i] = position;
+		}
+		_smoothingSum[slot] = position * _smoothingLength;
+	}
+}
+
+void MotionAxis::tick(unsigned long now)
+{
+	_currentMillis = now;
+
+	int32_t dt = min(now - _previousMillis, (unsigned long)MotionAxis_MAX_STEP);
+	_previousMillis = now;
+	_step = dt;
+
+	uint32_t moving = _movingMask;
+	for (uint8_t axis = 0; moving != 0; axis++, moving >>= 1)
+	{
+		if ((moving & 1) == 0)
+		{
+			continue;
+		}
+
+		int32_t previous = _position[axis];
+		uint8_t slot = _plan[axis];
+		if (slot != MotionAxis_NO_PLAN)
+		{
+			if (plan(axis, slot, dt))
+			{
+				_movingMask &= ~((uint32_t)1 << axis);
+			}
+		}
+		else if ((_queuedMask & ((uint32_t)1 << axis)) != 0)
+		{
+			if (followQueue(axis, _queue[axis], now))
+			{
+				_movingMask &= ~((uint32_t)1 << axis);
+				_queuedMask &= ~((uint32_t)1 << axis);
+			}
+		}
+		else
+		{
+			uint32_t progress = motionProgress(now - _startMillis[axis], _duration[axis]);
+			if (progress >= (uint32_t)MotionMath_ONE)
+			{
+				_position[axis] = _target[axis];
+				_movingMask &= ~((uint32_t)1 << axis);
+			}
+			else
+			{
+				_position[axis] = motionLerp(_start[axis], _target[axis], ease(_curve[axis], progress));
+			}
+		}
+
+		_delta[axis] = _position[axis] - previous;
+		_output[axis] = _position[axis];
+		// Layered axes are written by mixLayers()
+		if (_channel[axis] != MotionAxis_NO_CHANNEL && (_layeredMask & ((uint32_t)1 << axis)) == 0)
+		{
+			_bus->setServo(_channel[axis], _position[axis]);
+		}
+	}
+
+	_smoothingIndex = (_smoothingIndex + 1) % _smoothingLength;
+
+	mixLayers(dt);
+	updateModel(dt);
+}
+
+void MotionAxis::refresh()
+{
+	for (uint8_t axis = 0; axis < _count; axis++)
+	{
+		if (_channel[axis] != MotionAxis_NO_CHANNEL)
+		{
+			_movingMask |= (uint32_t)1 << axis;
+		}
+	}
+}
+
+// One pass over all layered axes: base position plus every offset times the weight of its layer
+void MotionAxis::mixLayers(int32_t dt)
+{
+	// Weight change of this tick, rounded up so a fade never takes longer than MotionAxis_WEIGHT_FADE
+	int16_t step = (MotionAxis_WEIGHT_ONE * dt + MotionAxis_WEIGHT_FADE - 1) / MotionAxis_WEIGHT_FADE;
+	for (uint8_t layer = 0; layer < MotionAxis_LAYERS; layer++)
+	{
+		int16_t change = (int16_t)_layerWeightTarget[layer] - (int16_t)_layerWeight[layer];
+		_layerWeight[layer] += constrain(change, (int16_t)-step, step);
+	}
+
+	uint32_t layered = _layeredMask;
+	for (uint8_t axis = 0; layered != 0; axis++, layered >>= 1)
+	{
+		if ((layered & 1) == 0)
+		{
+			continue;
+		}
+
+		int32_t output = _position[axis];
+		for (uint8_t layer = 0; layer < MotionAxis_LAYERS; layer++)
+		{
+			uint8_t offset = _layer[axis][layer];
+			if (offset != MotionAxis_NO_AXIS)
+			{
+				output += (_position[offset] * _layerWeight[layer]) >> 8;
+			}
+		}
+		output = constrain(output, _outputMin[axis], _outputMax[axis]);
+		_output[axis] = output;
+
+		if (_channel[axis] != MotionAxis_NO_CHANNEL)
+		{
+			_bus->setServo(_channel[axis], output);
+		}
+	}
+}
+
+unsigned long MotionAxis::now()
+{
+	return _currentMillis;
+}
+
+int32_t MotionAxis::position(uint8_t axis)
+{
+	return _position[axis];
+}
+
+int32_t MotionAxis::output(uint8_t axis)
+{
+	return _output[axis];
+}
+
+int32_t MotionAxis::target(uint8_t axis)
+{
+	return _target[axis];
+}
+
+int32_t MotionAxis::velocity(uint8_t axis)
+{
+	if (_plan[axis] != MotionAxis_NO_PLAN)
+	{
+		return _velocity[_plan[axis]];
+	}
+	if (isMoving(axis) == false || _step == 0)
+	{
+		return 0;
+	}
+	return (int32_t)((int64_t)_delta[axis] * 1000 / _step);
+}
+
+uint8_t MotionAxis::queueDepth(uint8_t axis)
+{
+	if (_queue[axis] == MotionAxis_NO_QUEUE)
+	{
+		return 0;
+	}
+	return _queueLength[_queue[axis]];
+}
+
+void MotionAxis::resetCounters()
+{
+	queuedCommands = 0;
+	droppedCommands = 0;
+	queuePeak = 0;
+	saturatedTicks = 0;
+}
+
+void MotionAxis::setDynamics(uint8_t axis, int32_t maxVelocity, uint16_t timeConstant)
+{
+	_modelVelocity[axis] = max(maxVelocity, (int32_t)1);
+	_modelTimeConstant[axis] = timeConstant;
+	_estimate[axis] = _output[axis];
+	_modelMask |= (uint32_t)1 << axis;
+
+	uint8_t slot = _plan[axis];
+	if (slot != MotionAxis_NO_PLAN)
+	{
+		_maxVelocity[slot] = min(_maxVelocity[slot], _modelVelocity[axis]);
+	}
+}
+
+int32_t MotionAxis::estimate(uint8_t axis)
+{
+	return (_modelMask & ((uint32_t)1 << axis)) != 0 ? _estimate[axis] : _output[axis];
+}
+
+// Moves every modelled servo towards its output: first-order lag (backward Euler, stable for any tick length)
+// capped by the velocity of the servo
+void MotionAxis::updateModel(int32_t dt)
+{
+	if (dt <= 0)
+	{
+		return;
+	}
+
+	bool saturated = false;
+	uint32_t modeled = _modelMask;
+	for (uint8_t axis = 0; modeled != 0; axis++, modeled >>= 1)
+	{
+		if ((modeled & 1) == 0)
+		{
+			continue;
+		}
+
+		int32_t error = _output[axis] - _estimate[axis];
+		if (error == 0)
+		{
+			continue;
+		}
+
+		int32_t step = (int32_t)((int64_t)error * dt / (_modelTimeConstant[axis] + dt));
+		if (step == 0)
+		{
+			step = error > 0 ? 1 : -1; // The last units of a lag would never arrive in integers
+		}
+
+		int32_t limit = max((int32_t)((int64_t)_modelVelocity[axis] * dt / 1000), (int32_t)1);
+		if (step > limit || step < -limit)
+		{
+			step = constrain(step, -limit, limit);
+			saturated = true;
+		}
+		_estimate[axis] += step;
+	}
+
+	if (saturated)
+	{
+		saturatedTicks++;
+	}
+}
+
+bool MotionAxis::isMoving(uint8_t axis)
+{
+	return (_movingMask & ((uint32_t)1 << axis)) != 0;
+}
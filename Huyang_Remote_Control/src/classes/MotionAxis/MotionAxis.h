@@ -0,0 +1,224 @@
+#ifndef MotionAxis_h
+#define MotionAxis_h
+
+#include "Arduino.h"
+#include "../PwmBus/PwmBus.h"
+#include "../MotionMath/MotionMath.h"
+#include "../MotionCurves/MotionCurves.h"
+
+#define MotionAxis_MAX_AXES 32     // One bit per axis in the moving mask
+#define MotionAxis_NO_CHANNEL 0xFF // Axis is not wired to a servo directly, its owner mixes it into servo values
+#define MotionAxis_NO_AXIS 0xFF
+
+// Additive layers (see addLayer())
+#define MotionAxis_LAYERS 2        // Idle and Gesture
+#define MotionAxis_WEIGHT_ONE 256  // Full layer weight
+#define MotionAxis_WEIGHT_FADE 500 // ms a layer takes to fade from 0 to full weight or back, at any tick rate
+
+// Velocity and acceleration limited axes (see setLimits())
+#define MotionAxis_MAX_PLANNED 6   // Number of axes that can use the planner
+#define MotionAxis_NO_PLAN 0xFF
+#define MotionAxis_SMOOTHING_MILLIS 133 // Length of the moving average that turns the trapezoid into an S-curve
+#define MotionAxis_MAX_SMOOTHING 16     // Ticks the moving average can hold, its full length up to 120 ticks per second
+#define MotionAxis_MAX_STEP 100    // Longest time step in ms the planner integrates at once
+
+// Streamed commands (see queueTo())
+#define MotionAxis_MAX_QUEUED 6    // Number of axes with a command queue
+#define MotionAxis_QUEUE_SIZE 8    // Commands per queue, the oldest waiting one is dropped when full
+#define MotionAxis_NO_QUEUE 0xFF
+
+// Servo model (see setDynamics())
+#define MotionAxis_CURVE_PEAK 2    // Peak velocity of a timed move as a multiple of its average, EaseInOutQuad reaches 2
+
+// Table of every motion axis of the droid (neck, body, monocle).
+// The data is stored as one array per field so tick() runs through all axes in one tight loop.
+// Axes with a channel hold their position in servo sub-ticks and are written to the PWM bus by tick(),
+// axes without a channel hold a Q8 value that their owner reads with output() and mixes into several servos.
+//
+// Every axis is the base layer (manual or sequenced moves). Additive layers are axes of their own that hold an
+// offset, tick() adds them with the weight of their layer to the base, so idle motion keeps running on top of
+// whatever the operator does.
+class MotionAxis
+{
+public:
+	enum Layer
+	{
+		Idle = 0,
+		Gesture = 1
+	};
+
+	// Easing of timed moves, all but Linear and EaseInOutQuad are read from the tables in MotionCurves.h.
+	// EaseOutBack and Spring swing past the target, keep some room to the end of the servo range.
+	enum Curve
+	{
+		Linear = 0,
+		EaseInOutQuad = 1,
+		EaseInOutCubic = 2,
+		EaseInOutSine = 3,
+		EaseOutBack = 4,
+		EaseOutBounce = 5,
+		Spring = 6
+	};
+
+	MotionAxis(PwmBus *bus);
+
+	// Registers a new axis at the given position, returns its index or MotionAxis_NO_AXIS if the table is full.
+	// The sketch checks the axes of neck and body against MotionAxis_MAX_AXES at compile time.
+	uint8_t addAxis(int32_t position, uint8_t channel = MotionAxis_NO_CHANNEL);
+
+	// Starts a movement from the current position to target, ignored if target is already set
+	void moveTo(uint8_t axis, int32_t target, uint16_t duration, Curve curve = EaseInOutQuad);
+	// Adds an offset axis for the layer on top of axis, returns its index or MotionAxis_NO_AXIS like addAxis().
+	// The offset starts at 0 and is moved with moveTo() like any other axis.
+	uint8_t addLayer(uint8_t axis, Layer layer);
+	// Weight of a layer from 0 to MotionAxis_WEIGHT_ONE, changes are faded in over MotionAxis_WEIGHT_FADE ms
+	void setLayerWeight(Layer layer, uint16_t weight);
+	// Keeps the output of a layered axis inside the range of its servo or mixer
+	void setOutputRange(uint8_t axis, int32_t min, int32_t max);
+
+	// Jumps to a position without easing
+	void setPosition(uint8_t axis, int32_t position);
+
+	// Coordinated moves: every moveTo() between beginMove() and commitMove() only collects its target,
+	// commitMove() then starts all collected axes at once and times them to arrive together.
+	// Timed axes share the duration, planned axes get their velocity and acceleration scaled down so the
+	// slowest one sets the pace. The job takes at least duration ms, the curve is used for all timed axes.
+	// Returns false if no axis got a new target.
+	void beginMove();
+	bool commitMove(uint16_t duration, Curve curve = EaseInOutQuad);
+
+	// Gives the axis a command queue for streamed input like a joystick.
+	// Queued targets are joined into one continuous trajectory: each one is a cubic segment that starts with the
+	// velocity the previous one ended with and, if the next command is already waiting, ends with the velocity
+	// towards that one, so a stream of targets never brakes to zero in between. Axes with a planner need no queue.
+	void enableQueue(uint8_t axis);
+	// Appends a target that should be reached duration ms after the previous one, usually the time between two inputs.
+	// A new target also shortens the running segment to at most duration, so the axis never lags more than one input behind.
+	// Axes without queue take it as a normal moveTo(). Returns false if the target is already the last one queued.
+	bool queueTo(uint8_t axis, int32_t target, uint16_t duration);
+	// Like commitMove(), but appends the collected targets to the queues with one common duration
+	bool queueMove(uint16_t duration);
+
+	// Moves the axis with the trajectory planner instead of a timed curve.
+	// Velocity in axis units per second, acceleration in units per second².
+	// The planner follows a trapezoidal velocity profile that is smoothed into an S-curve over MotionAxis_SMOOTHING_MILLIS,
+	// a new target in the middle of a move is picked up from the current velocity without a jump.
+	// With a planner the duration of moveTo() only lowers the cruise velocity, it never exceeds the limits.
+	void setLimits(uint8_t axis, int32_t maxVelocity, int32_t maxAcceleration);
+
+	// Models the servo behind the axis so estimate() can tell where it really is. The servo follows the output
+	// with a first-order lag of timeConstant ms (its control loop) and never faster than maxVelocity in axis units
+	// per second (its motor, from the speed on the data sheet). Coordinated moves are stretched so no modelled
+	// servo has to exceed its velocity, a planner limit above it is lowered, so call this after setLimits().
+	void setDynamics(uint8_t axis, int32_t maxVelocity, uint16_t timeConstant);
+
+	// Control ticks per second (60 until set), sizes the moving average of the planner so it spans the same time
+	// at any rate. Call it in setup(), the averages restart from the planner positions.
+	void setTickRate(uint16_t tickRate);
+	// Advances all moving axes to the given time, call once per control tick with MotionClock::now()
+	void tick(unsigned long now);
+	// Writes every servo axis again on the next tick, e.g. after its calibration changed
+	void refresh();
+	// Time of the last tick, subsystems use it instead of millis() so one pass sees one time
+	unsigned long now();
+
+	// Position of the base layer
+	int32_t position(uint8_t axis);
+	// Base position plus all weighted layers, this is what reaches the servo
+	int32_t output(uint8_t axis);
+	int32_t target(uint8_t axis);
+	bool isMoving(uint8_t axis);
+	// Current velocity in units per second, from the planner or from the last tick
+	int32_t velocity(uint8_t axis);
+	// Commands waiting in the queue of the axis
+	uint8_t queueDepth(uint8_t axis);
+	// Estimated real position of the servo (see setDynamics()), the output for axes without a model
+	int32_t estimate(uint8_t axis);
+
+	// Queue counters over all axes, like the traffic counters of PwmFrame
+	uint32_t queuedCommands = 0;  // Targets appended by queueTo()
+	uint32_t droppedCommands = 0; // Targets dropped from full queues
+	uint8_t queuePeak = 0;        // Deepest queue seen
+	uint32_t saturatedTicks = 0;  // Ticks in which a modelled servo could not keep up with its output
+	void resetCounters();
+
+private:
+	PwmBus *_bus;
+
+	uint8_t _count = 0;
+	uint32_t _movingMask = 0; // Bit set = axis has not reached its target yet
+
+	int32_t _start[MotionAxis_MAX_AXES];    // Position when the current movement started
+	int32_t _target[MotionAxis_MAX_AXES];   // Target of the current movement
+	int32_t _position[MotionAxis_MAX_AXES]; // Position of the last tick
+	unsigned long _startMillis[MotionAxis_MAX_AXES];
+	uint16_t _duration[MotionAxis_MAX_AXES];
+	uint8_t _curve[MotionAxis_MAX_AXES];
+	uint8_t _channel[MotionAxis_MAX_AXES];
+
+	uint8_t _plan[MotionAxis_MAX_AXES];     // Planner slot of the axis or MotionAxis_NO_PLAN
+	int32_t _output[MotionAxis_MAX_AXES];   // Position with all layers added
+	int32_t _delta[MotionAxis_MAX_AXES];    // Position change of the last tick
+
+	// Layers, one offset axis per base axis and layer
+	uint32_t _layeredMask = 0; // Bit set = axis has at least one layer
+	uint8_t _layer[MotionAxis_MAX_AXES][MotionAxis_LAYERS];
+	int32_t _outputMin[MotionAxis_MAX_AXES];
+	int32_t _outputMax[MotionAxis_MAX_AXES];
+	uint16_t _layerWeight[MotionAxis_LAYERS] = {MotionAxis_WEIGHT_ONE, MotionAxis_WEIGHT_ONE};
+	uint16_t _layerWeightTarget[MotionAxis_LAYERS] = {MotionAxis_WEIGHT_ONE, MotionAxis_WEIGHT_ONE};
+
+	// Coordinated move being collected, see beginMove()
+	bool _collecting = false;
+	uint32_t _jobMask = 0;
+	int32_t _jobTarget[MotionAxis_MAX_AXES];
+
+	// Planner slots, again one array per field
+	uint8_t _planCount = 0;
+	int32_t _planPosition[MotionAxis_MAX_PLANNED];   // Raw trapezoid position before smoothing
+	int32_t _velocity[MotionAxis_MAX_PLANNED];       // Units per second
+	int16_t _residual[MotionAxis_MAX_PLANNED];       // Remainder of the last position step in unit-milliseconds
+	int32_t _maxVelocity[MotionAxis_MAX_PLANNED];
+	int32_t _maxAcceleration[MotionAxis_MAX_PLANNED];
+	int32_t _acceleration[MotionAxis_MAX_PLANNED];   // Acceleration of the current move, lower in coordinated moves
+	int32_t _cruiseVelocity[MotionAxis_MAX_PLANNED]; // Velocity limit of the current move
+	int32_t _smoothing[MotionAxis_MAX_PLANNED][MotionAxis_MAX_SMOOTHING];
+	int32_t _smoothingSum[MotionAxis_MAX_PLANNED];
+	uint8_t _smoothingIndex = 0;                     // Shared, idle slots hold a constant value so the index does not matter
+	uint8_t _smoothingLength = 1;                    // Ticks in the moving average, see setTickRate()
+	uint16_t _smoothingDelay = 0;                    // ms the average trails the trapezoid at that tick rate
+
+	// Command queues, ring buffers of one slot per queued axis
+	uint8_t _queue[MotionAxis_MAX_AXES];    // Queue slot of the axis or MotionAxis_NO_QUEUE
+	uint32_t _queuedMask = 0;               // Bit set = the current move is a queued segment
+	uint8_t _queueCount = 0;
+	int32_t _queueTarget[MotionAxis_MAX_QUEUED][MotionAxis_QUEUE_SIZE];
+	uint16_t _queueDuration[MotionAxis_MAX_QUEUED][MotionAxis_QUEUE_SIZE];
+	uint8_t _queueHead[MotionAxis_MAX_QUEUED];
+	uint8_t _queueLength[MotionAxis_MAX_QUEUED];
+	int32_t _tangentStart[MotionAxis_MAX_QUEUED];    // Velocity at the segment start times its duration, in axis units
+	int32_t _tangentEnd[MotionAxis_MAX_QUEUED];
+
+	// Servo model, only axes in _modelMask are updated
+	uint32_t _modelMask = 0;
+	int32_t _estimate[MotionAxis_MAX_AXES];
+	int32_t _modelVelocity[MotionAxis_MAX_AXES];     // Axis units per second
+	uint16_t _modelTimeConstant[MotionAxis_MAX_AXES]; // ms
+
+	unsigned long _currentMillis = 0;
+	unsigned long _previousMillis = 0;
+	int32_t _step = 0; // Length of the last tick in ms
+
+	void startMove(uint8_t axis, int32_t target, uint16_t duration, Curve curve);
+	int32_t ease(uint8_t curve, uint32_t progress);
+	bool plan(uint8_t axis, uint8_t slot, int32_t dt);
+	void mixLayers(int32_t dt);
+	void updateModel(int32_t dt);
+	void resetPlan(uint8_t slot, int32_t position);
+	void startSegment(uint8_t axis, uint8_t slot, int32_t velocity);
+	void blendSegment(uint8_t axis, uint8_t slot, uint16_t duration);
+	int32_t segmentTangent(uint8_t slot, int32_t start, int32_t target, uint16_t duration);
+	bool followQueue(uint8_t axis, uint8_t slot, unsigned long now);
+};
+
+#endif
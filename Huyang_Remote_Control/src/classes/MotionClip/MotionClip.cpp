@@ -0,0 +1,196 @@
+#include "MotionClip.h"
+
+static uint32_t MotionClip_read32(const uint8_t *bytes)
+{
+	return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint16_t MotionClip_read16(const uint8_t *bytes)
+{
+	return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+bool MotionClip::begin(Source *source)
+{
+	_source = source;
+	_bufferSize = 0;
+	_bufferIndex = 0;
+
+	uint8_t header[MotionClip_HEADER_SIZE];
+	if (_source->seek(0) == false || readBytes(header, sizeof(header)) == false || memcmp(header, MotionClip_MAGIC, 4) != 0)
+	{
+		return false;
+	}
+
+	_length = MotionClip_read32(header + 4);
+	_timeStep = MotionClip_read16(header + 8);
+	_trackCount = header[10];
+	_indexInterval = header[11];
+	_recordCount = MotionClip_read32(header + 12);
+	_indexCount = MotionClip_read16(header + 16);
+
+	if (_trackCount > MotionClip_MAX_TRACKS || _timeStep == 0 || readBytes(_curves, _trackCount) == false)
+	{
+		return false;
+	}
+
+	_recordsOffset = MotionClip_HEADER_SIZE + _trackCount + (uint32_t)_indexCount * indexEntrySize();
+	return rewind();
+}
+
+bool MotionClip::rewind()
+{
+	_time = 0;
+	memset(_values, 0, sizeof(_values));
+	_recordsLeft = _recordCount;
+	return position(_recordsOffset);
+}
+
+bool MotionClip::next(Event &event)
+{
+	if (_recordsLeft == 0)
+	{
+		return false;
+	}
+
+	uint8_t track;
+	uint32_t delta;
+	uint32_t duration;
+	uint32_t zigzag;
+	if (readByte(track) == false || readVarint(delta) == false || readVarint(duration) == false || readVarint(zigzag) == false || track >= _trackCount)
+	{
+		_recordsLeft = 0;
+		return false;
+	}
+	_recordsLeft--;
+
+	// Zigzag keeps small negative deltas small: 0, -1, 1, -2 ... are stored as 0, 1, 2, 3 ...
+	int32_t change = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+	_time += delta;
+	_values[track] += change;
+
+	event.start = _time * _timeStep;
+	event.duration = duration * _timeStep;
+	event.track = track;
+	event.curve = _curves[track];
+	event.value = _values[track];
+	return true;
+}
+
+bool MotionClip::seek(uint32_t time)
+{
+	if (rewind() == false)
+	{
+		return false;
+	}
+
+	uint32_t offset = _recordsOffset;
+	uint32_t skipped = 0;
+
+	// The index is read entry by entry, no table has to fit in RAM.
+	// Entry i points to record (i + 1) * interval.
+	uint8_t entry[8 + MotionClip_MAX_TRACKS * 2];
+	uint8_t entrySize = indexEntrySize();
+	for (uint16_t i = 0; i < _indexCount; i++)
+	{
+		if (position(MotionClip_HEADER_SIZE + _trackCount + (uint32_t)i * entrySize) == false || readBytes(entry, entrySize) == false)
+		{
+			return false;
+		}
+		uint32_t entryTime = MotionClip_read32(entry);
+		if (entryTime > time)
+		{
+			break;
+		}
+
+		offset = MotionClip_read32(entry + 4);
+		_time = entryTime / _timeStep;
+		for (uint8_t track = 0; track < _trackCount; track++)
+		{
+			_values[track] = (int16_t)MotionClip_read16(entry + 8 + track * 2);
+		}
+		skipped = (uint32_t)(i + 1) * _indexInterval;
+	}
+
+	_recordsLeft = skipped < _recordCount ? _recordCount - skipped : 0;
+	return position(offset);
+}
+
+uint32_t MotionClip::length()
+{
+	return _length;
+}
+
+uint32_t MotionClip::recordCount()
+{
+	return _recordCount;
+}
+
+uint8_t MotionClip::trackCount()
+{
+	return _trackCount;
+}
+
+int16_t MotionClip::value(uint8_t track)
+{
+	return _values[track];
+}
+
+bool MotionClip::position(uint32_t offset)
+{
+	_bufferSize = 0;
+	_bufferIndex = 0;
+	return _source->seek(offset);
+}
+
+bool MotionClip::readByte(uint8_t &value)
+{
+	if (_bufferIndex >= _bufferSize)
+	{
+		_bufferSize = _source->read(_buffer, sizeof(_buffer));
+		_bufferIndex = 0;
+		if (_bufferSize == 0)
+		{
+			return false;
+		}
+	}
+	value = _buffer[_bufferIndex++];
+	return true;
+}
+
+bool MotionClip::readBytes(uint8_t *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		if (readByte(data[i]) == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Seven bits per byte, lowest first, the high bit marks that another byte follows
+bool MotionClip::readVarint(uint32_t &value)
+{
+	value = 0;
+	for (uint8_t shift = 0; shift < 32; shift += 7)
+	{
+		uint8_t byte;
+		if (readByte(byte) == false)
+		{
+			return false;
+		}
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint8_t MotionClip::indexEntrySize()
+{
+	return 8 + _trackCount * 2;
+}
@@ -0,0 +1,112 @@
+#ifndef MotionClip_h
+#define MotionClip_h
+
+// Shared with the host clip compiler in tools/clipc, so no Arduino dependencies outside this block
+#ifdef ARDUINO
+#include "Arduino.h"
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+// Binary clip format "HYC2", little-endian, written by tools/clipc:
+//
+//   Header      magic "HYC2", length in ms (uint32), time step in ms (uint16), track count (uint8),
+//               records per index entry (uint8), record count (uint32), index entry count (uint16)
+//   Curves      one byte per track, MotionAxis::Curve of all moves on that track
+//   Seek index  entry i points to record (i + 1) * records per index entry:
+//               start of the record before it in ms (uint32), file offset of the record (uint32),
+//               value of every track after all records before it (int16 each)
+//   Records     sorted by start time, one move each:
+//                 track (uint8), start - previous start in time steps (varint), duration in time steps (varint),
+//                 value - previous value of the track (zigzag varint)
+//
+// A record moves its track from wherever it is to value, starting at start and arriving after duration.
+// Eye and light tracks switch at start, their records have no duration. All tracks start at 0.
+#define MotionClip_MAGIC "HYC2"
+#define MotionClip_HEADER_SIZE 18
+#define MotionClip_MAX_TRACKS 16
+#define MotionClip_BUFFER_SIZE 32 // Bytes read from the source at once
+
+// Streaming decoder for HYC2 clips. Works on a small fixed buffer, never allocates,
+// so it plays clips of any length from flash on the device and from files on the host.
+class MotionClip
+{
+public:
+	enum Track
+	{
+		NeckRotate = 0,
+		NeckTiltForward = 1,
+		NeckTiltSideways = 2,
+		Monocle = 3,
+		BodyRotate = 4,
+		BodyTiltForward = 5,
+		BodyTiltSideways = 6,
+		LeftEye = 7,
+		RightEye = 8,
+		ChestLight = 9,
+		TrackCount = 10
+	};
+
+	// Where the clip bytes come from, a LittleFS file on the device or a FILE* / memory block on the host
+	class Source
+	{
+	public:
+		virtual size_t read(uint8_t *buffer, size_t size) = 0;
+		virtual bool seek(uint32_t offset) = 0;
+	};
+
+	struct Event
+	{
+		uint32_t start;    // Clip time in ms
+		uint32_t duration; // ms
+		uint8_t track;
+		uint8_t curve;     // MotionAxis::Curve
+		int16_t value;
+	};
+
+	// Reads the header and positions at the first record, false if the source is no HYC2 clip
+	bool begin(Source *source);
+	// Positions at the first record again, all tracks at 0
+	bool rewind();
+	// Decodes the next record, false at the end of the clip or on broken data
+	bool next(Event &event);
+	// Positions at the last index entry at or before time, the following next() calls start from there.
+	// Records between that entry and time still come out of next(), the caller decides what to do with them.
+	bool seek(uint32_t time);
+
+	uint32_t length();
+	uint32_t recordCount();
+	uint8_t trackCount();
+	// Value of a track after the last decoded record
+	int16_t value(uint8_t track);
+
+private:
+	Source *_source = nullptr;
+
+	uint32_t _length = 0;
+	uint16_t _timeStep = 1;
+	uint8_t _trackCount = 0;
+	uint8_t _indexInterval = 0;
+	uint32_t _recordCount = 0;
+	uint16_t _indexCount = 0;
+	uint32_t _recordsOffset = 0;
+	uint8_t _curves[MotionClip_MAX_TRACKS];
+
+	uint32_t _recordsLeft = 0;
+	uint32_t _time = 0; // Start of the last record in time steps
+	int16_t _values[MotionClip_MAX_TRACKS];
+
+	uint8_t _buffer[MotionClip_BUFFER_SIZE];
+	uint8_t _bufferSize = 0;
+	uint8_t _bufferIndex = 0;
+
+	bool position(uint32_t offset);
+	bool readByte(uint8_t &value);
+	bool readBytes(uint8_t *data, size_t size);
+	bool readVarint(uint32_t &value);
+	uint8_t indexEntrySize();
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "MotionClock.h"
+
+MotionClock::MotionClock(uint16_t tickRate)
+{
+	setTickRate(tickRate);
+	_lastMicros = micros();
+}
+
+void MotionClock::setTickRate(uint16_t tickRate)
+{
+	if (tickRate == 0)
+	{
+		tickRate = 1;
+	}
+	_tickRate = tickRate;
+	_tickPeriodMicros = 1000000UL / tickRate;
+}
+
+uint16_t MotionClock::tickRate()
+{
+	return _tickRate;
+}
+
+bool MotionClock::update()
+{
+	// micros() wraps every ~71 minutes, the unsigned difference does not care
+	unsigned long currentMicros = micros();
+	unsigned long passed = currentMicros - _lastMicros;
+	_lastMicros = currentMicros;
+
+	_elapsedMicros += passed;
+	_nowMicros += passed;
+	_loopCount++;
+
+	if (_elapsedMicros < _tickPeriodMicros)
+	{
+		return false;
+	}
+
+	// Skip missed ticks instead of catching up, motion is time-based anyway
+	_elapsedMicros = _elapsedMicros % _tickPeriodMicros;
+
+	_previousMillis = _nowMillis;
+	_nowMillis += _nowMicros / 1000;
+	_nowMicros = _nowMicros % 1000;
+
+	loopsPerTick = _loopCount;
+	_loopCount = 0;
+
+	return true;
+}
+
+unsigned long MotionClock::now()
+{
+	return _nowMillis;
+}
+
+uint16_t MotionClock::delta()
+{
+	return _nowMillis - _previousMillis;
+}
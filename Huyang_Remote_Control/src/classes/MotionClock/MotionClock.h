@@ -0,0 +1,42 @@
+#ifndef MotionClock_h
+#define MotionClock_h
+
+#include "Arduino.h"
+
+// The one clock all motion runs on.
+// update() samples micros() once per loop and reports when the next control tick is due,
+// now() is the timestamp of that tick and is what every axis, planner and timer uses for that pass.
+// Motion is computed from elapsed time, so the tick rate only changes how often servos are updated, not how fast they move.
+class MotionClock
+{
+public:
+	MotionClock(uint16_t tickRate);
+
+	// Samples the clock, returns true when a control tick is due
+	bool update();
+
+	// Milliseconds since start, taken at the last control tick
+	unsigned long now();
+	// Milliseconds between the last two control ticks
+	uint16_t delta();
+
+	// Control ticks per second
+	void setTickRate(uint16_t tickRate);
+	uint16_t tickRate();
+
+	// Number of loop passes between the last two control ticks, shows how busy loop() is
+	uint16_t loopsPerTick = 0;
+
+private:
+	uint16_t _tickRate = 60;
+	unsigned long _tickPeriodMicros = 16666;
+
+	unsigned long _lastMicros = 0;     // micros() at the last update()
+	unsigned long _elapsedMicros = 0;  // Micros accumulated towards the next tick
+	unsigned long _nowMicros = 0;      // Sub-millisecond part carried between ticks
+	unsigned long _nowMillis = 0;      // Monotonic time at the last tick
+	unsigned long _previousMillis = 0; // Monotonic time at the tick before
+	uint16_t _loopCount = 0;
+};
+
+#endif
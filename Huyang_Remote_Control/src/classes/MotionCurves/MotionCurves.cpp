@@ -0,0 +1,143 @@
+#include "MotionCurves.h"
+
+// Everything in this file up to the table is only evaluated by the compiler,
+// the doubles never reach the firmware.
+
+namespace
+{
+	constexpr double Pi = 3.14159265358979323846;
+
+	// Taylor series of sine after reducing x to -pi..pi, good to ~1e-9
+	constexpr double curveSin(double x)
+	{
+		while (x > Pi)
+		{
+			x -= 2 * Pi;
+		}
+		while (x < -Pi)
+		{
+			x += 2 * Pi;
+		}
+		double term = x;
+		double sum = x;
+		for (int i = 1; i < 12; i++)
+		{
+			term *= -x * x / ((2 * i) * (2 * i + 1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double curveCos(double x)
+	{
+		return curveSin(x + Pi / 2);
+	}
+
+	// e^x for x <= 0, series of e^-x is only summed for positive values and inverted
+	constexpr double curveExpNegative(double x)
+	{
+		double term = 1;
+		double sum = 1;
+		for (int i = 1; i < 40; i++)
+		{
+			term *= -x / i;
+			sum += term;
+		}
+		return 1 / sum;
+	}
+
+	constexpr double easeInOutCubic(double t)
+	{
+		if (t < 0.5)
+		{
+			return 4 * t * t * t;
+		}
+		double u = -2 * t + 2;
+		return 1 - u * u * u / 2;
+	}
+
+	constexpr double easeInOutSine(double t)
+	{
+		return (1 - curveCos(Pi * t)) / 2;
+	}
+
+	// Overshoots by ~10% and settles back
+	constexpr double easeOutBack(double t)
+	{
+		const double c1 = 1.70158;
+		const double c3 = c1 + 1;
+		double u = t - 1;
+		return 1 + c3 * u * u * u + c1 * u * u;
+	}
+
+	// Hits the target and bounces off it three times with falling height
+	constexpr double easeOutBounce(double t)
+	{
+		const double n1 = 7.5625;
+		const double d1 = 2.75;
+
+		if (t < 1 / d1)
+		{
+			return n1 * t * t;
+		}
+		if (t < 2 / d1)
+		{
+			t -= 1.5 / d1;
+			return n1 * t * t + 0.75;
+		}
+		if (t < 2.5 / d1)
+		{
+			t -= 2.25 / d1;
+			return n1 * t * t + 0.9375;
+		}
+		t -= 2.625 / d1;
+		return n1 * t * t + 0.984375;
+	}
+
+	// Damped oscillation around the target, 2.5 swings that decay to nothing at the end
+	constexpr double spring(double t)
+	{
+		return 1 - curveExpNegative(-6 * t) * curveCos(2 * Pi * 2.5 * t);
+	}
+
+	constexpr double curveValue(int curve, double t)
+	{
+		switch (curve)
+		{
+		case MotionCurves_EASE_IN_OUT_CUBIC:
+			return easeInOutCubic(t);
+		case MotionCurves_EASE_IN_OUT_SINE:
+			return easeInOutSine(t);
+		case MotionCurves_EASE_OUT_BACK:
+			return easeOutBack(t);
+		case MotionCurves_EASE_OUT_BOUNCE:
+			return easeOutBounce(t);
+		default:
+			return spring(t);
+		}
+	}
+
+	constexpr MotionCurveTables buildCurveTables()
+	{
+		MotionCurveTables tables = {};
+		for (int curve = 0; curve < MotionCurves_COUNT; curve++)
+		{
+			for (int i = 0; i < MotionCurves_POINTS; i++)
+			{
+				double value = curveValue(curve, (double)i / MotionCurves_SEGMENTS);
+				tables.values[curve][i] = (int32_t)(value * MotionMath_ONE + (value < 0 ? -0.5 : 0.5));
+			}
+			// Every curve starts and ends exactly on its start and target
+			tables.values[curve][0] = 0;
+			tables.values[curve][MotionCurves_SEGMENTS] = MotionMath_ONE;
+		}
+		for (int i = 0; i <= MotionCurves_SINE_SEGMENTS; i++)
+		{
+			tables.sine[i] = (int32_t)(curveSin(Pi / 2 * i / MotionCurves_SINE_SEGMENTS) * MotionMath_ONE + 0.5);
+		}
+		return tables;
+	}
+}
+
+// constexpr forces the whole table to be computed at compile time
+constexpr MotionCurveTables motionCurveTables PROGMEM = buildCurveTables();
@@ -0,0 +1,77 @@
+#ifndef MotionCurves_h
+#define MotionCurves_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+
+// Easing curves as lookup tables in flash.
+// The tables are generated by the compiler from the constexpr curve functions in MotionCurves.cpp,
+// at runtime a curve costs one table read and one linear interpolation instead of the float math behind it.
+// Values are Q16 like MotionMath_ONE, back and spring overshoot the target, so they can leave 0..1.
+
+#define MotionCurves_SEGMENT_BITS 6                                // 64 segments per curve
+#define MotionCurves_SEGMENTS (1 << MotionCurves_SEGMENT_BITS)
+#define MotionCurves_POINTS (MotionCurves_SEGMENTS + 1)
+#define MotionCurves_FRACTION_BITS (16 - MotionCurves_SEGMENT_BITS) // Q16 progress bits between two points
+
+// Table index of each curve
+#define MotionCurves_EASE_IN_OUT_CUBIC 0
+#define MotionCurves_EASE_IN_OUT_SINE 1
+#define MotionCurves_EASE_OUT_BACK 2
+#define MotionCurves_EASE_OUT_BOUNCE 3
+#define MotionCurves_SPRING 4
+#define MotionCurves_COUNT 5
+
+// Quarter wave of the sine for oscillators, the other three quarters are mirrored from it
+#define MotionCurves_SINE_BITS 6                                    // 64 segments per quarter
+#define MotionCurves_SINE_SEGMENTS (1 << MotionCurves_SINE_BITS)
+#define MotionCurves_SINE_FRACTION_BITS (14 - MotionCurves_SINE_BITS) // Q16 phase bits between two points
+
+struct MotionCurveTables
+{
+	int32_t values[MotionCurves_COUNT][MotionCurves_POINTS];
+	int32_t sine[MotionCurves_SINE_SEGMENTS + 1];
+};
+
+extern const MotionCurveTables motionCurveTables PROGMEM;
+
+// Curve value for a Q16 progress (0..MotionMath_ONE), interpolated between the two nearest table points
+inline int32_t motionCurve(uint8_t curve, uint32_t progress)
+{
+	if (progress >= (uint32_t)MotionMath_ONE)
+	{
+		return MotionMath_ONE;
+	}
+
+	const int32_t *table = motionCurveTables.values[curve];
+	uint32_t index = progress >> MotionCurves_FRACTION_BITS;
+	int32_t fraction = progress & ((1 << MotionCurves_FRACTION_BITS) - 1);
+	int32_t from = (int32_t)pgm_read_dword(table + index);
+	int32_t to = (int32_t)pgm_read_dword(table + index + 1);
+
+	return from + (int32_t)(((int64_t)(to - from) * fraction) >> MotionCurves_FRACTION_BITS);
+}
+
+// Sine of a Q16 phase (65536 = one full cycle) as Q16 (-MotionMath_ONE..MotionMath_ONE), interpolated like motionCurve()
+inline int32_t motionSine(uint16_t phase)
+{
+	uint16_t quarter = phase & 0x3FFF;
+	if (phase & 0x4000) // Second and fourth quarter run backwards through the table
+	{
+		quarter = 0x4000 - quarter;
+	}
+
+	uint16_t index = quarter >> MotionCurves_SINE_FRACTION_BITS;
+	int32_t fraction = quarter & ((1 << MotionCurves_SINE_FRACTION_BITS) - 1);
+	int32_t from = (int32_t)pgm_read_dword(motionCurveTables.sine + index);
+	int32_t value = from;
+	if (fraction != 0)
+	{
+		int32_t to = (int32_t)pgm_read_dword(motionCurveTables.sine + index + 1);
+		value += ((to - from) * fraction) >> MotionCurves_SINE_FRACTION_BITS;
+	}
+
+	return (phase & 0x8000) ? -value : value;
+}
+
+#endif
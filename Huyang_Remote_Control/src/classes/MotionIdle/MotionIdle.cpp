@@ -0,0 +1,85 @@
+#include "MotionIdle.h"
+
+// The gradient table is filled by the compiler, like the curve tables in MotionCurves.cpp
+namespace
+{
+	// xorshift32, gives the same pseudo-random gradients on every build
+	constexpr uint32_t idleHash(uint32_t x)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		return x;
+	}
+
+	constexpr MotionIdleGradients buildGradients()
+	{
+		MotionIdleGradients gradients = {};
+		uint32_t state = 0x9E3779B9;
+		for (int i = 0; i < MotionIdle_GRADIENTS; i++)
+		{
+			state = idleHash(state);
+			gradients.values[i] = (int16_t)((int32_t)(state % 32769) - 16384);
+		}
+		return gradients;
+	}
+}
+
+constexpr MotionIdleGradients motionIdleGradients PROGMEM = buildGradients();
+
+MotionIdle::MotionIdle(MotionAxis *motion, uint8_t seed)
+{
+	_motion = motion;
+	_seed = seed;
+}
+
+void MotionIdle::add(uint8_t axis, int32_t amplitude, uint16_t frequency, int32_t center)
+{
+	if (_count >= MotionIdle_MAX_CHANNELS)
+	{
+		return;
+	}
+
+	_axis[_count] = axis;
+	_center[_count] = center;
+	_amplitude[_count] = amplitude;
+	_step[_count] = (uint32_t)frequency * 65536UL / 1000; // Q8 Hz to Q24 lattice steps per ms
+	_breathAmplitude[_count] = 0;
+	_breathStep[_count] = 0;
+	_offset[_count] = 0;
+	_count++;
+}
+
+void MotionIdle::breathe(uint8_t axis, int32_t amplitude, uint16_t period)
+{
+	for (uint8_t channel = 0; channel < _count; channel++)
+	{
+		if (_axis[channel] == axis)
+		{
+			_breathAmplitude[channel] = amplitude;
+			_breathStep[channel] = (1UL << 24) / max(period, (uint16_t)1);
+		}
+	}
+}
+
+void MotionIdle::tick(unsigned long now)
+{
+	for (uint8_t channel = 0; channel < _count; channel++)
+	{
+		// Every channel reads its own stretch of the table, the second octave runs twice as fast at half the height
+		uint32_t position = (uint32_t)now * _step[channel] + ((uint32_t)(_seed + channel * 83) << 24);
+		int32_t noise = (2 * motionNoise(position) + motionNoise((position << 1) + ((uint32_t)0x80 << 24))) / 3;
+		int32_t offset = _center[channel] + ((_amplitude[channel] * noise) >> 16);
+
+		if (_breathAmplitude[channel] != 0)
+		{
+			offset += (_breathAmplitude[channel] * motionSine(((uint32_t)now * _breathStep[channel]) >> 8)) >> 16;
+		}
+
+		if (offset != _offset[channel])
+		{
+			_offset[channel] = offset;
+			_motion->setPosition(_axis[channel], offset);
+		}
+	}
+}
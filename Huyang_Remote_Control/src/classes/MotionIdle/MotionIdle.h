@@ -0,0 +1,74 @@
+#ifndef MotionIdle_h
+#define MotionIdle_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+#include "../MotionCurves/MotionCurves.h" // Sine table for breathing
+#include "../MotionAxis/MotionAxis.h"
+
+#define MotionIdle_MAX_CHANNELS 3 // Idle layers of one subsystem
+#define MotionIdle_GRADIENTS 256  // Lattice points of the noise, the pattern repeats after that many steps
+
+// Gradient of every lattice point in Q14 (-1..1), generated by the compiler in MotionIdle.cpp
+struct MotionIdleGradients
+{
+	int16_t values[MotionIdle_GRADIENTS];
+};
+
+extern const MotionIdleGradients motionIdleGradients PROGMEM;
+
+// One-dimensional gradient noise of a Q24 lattice position (1 << 24 = one lattice step), Q16 result in -1..1.
+// Band-limited: it changes direction about once per lattice step and is smooth up to its second derivative,
+// so an axis that follows it never jerks. The position wraps with uint32_t exactly at the end of the table.
+inline int32_t motionNoise(uint32_t position)
+{
+	uint8_t index = position >> 24;
+	int32_t fraction = (position >> 8) & 0xFFFF; // Q16 between two lattice points
+
+	int32_t from = ((int32_t)(int16_t)pgm_read_word(motionIdleGradients.values + index) * fraction) >> 16;
+	int32_t to = ((int32_t)(int16_t)pgm_read_word(motionIdleGradients.values + (uint8_t)(index + 1)) * (fraction - MotionMath_ONE)) >> 16;
+
+	// Quintic fade 6f^5 - 15f^4 + 10f^3
+	uint32_t f2 = ((uint32_t)fraction * fraction) >> 16;
+	uint32_t f3 = (f2 * fraction) >> 16;
+	int32_t fade = (int32_t)(((int64_t)f3 * (10 * MotionMath_ONE - 15 * fraction + (int32_t)(6 * f2))) >> 16);
+
+	// The value of 1D gradient noise stays within half the gradient, Q14 * 2 gives Q16 -1..1
+	return constrain(motionLerp(from, to, fade) * 8, -MotionMath_ONE, MotionMath_ONE);
+}
+
+// Continuous idle motion of the idle layer axes of one subsystem.
+// Every axis follows two octaves of gradient noise around its center instead of jumping to random targets,
+// an optional slow sine on top makes the droid breathe. The offsets are a function of the time only,
+// tick() samples each axis once and has no timers or state that could pile up.
+class MotionIdle
+{
+public:
+	// seed shifts the noise of this subsystem, so neck and body do not move in step
+	MotionIdle(MotionAxis *motion, uint8_t seed);
+
+	// Drives the layer axis with noise. Center and amplitude in axis units, the offset stays within center +- amplitude.
+	// Frequency in Q8 Hz is how often the motion changes direction on average.
+	void add(uint8_t axis, int32_t amplitude, uint16_t frequency, int32_t center = 0);
+	// Adds a breath to an axis added before, amplitude in axis units and the time of one breath in ms
+	void breathe(uint8_t axis, int32_t amplitude, uint16_t period);
+
+	// Writes the offsets for the given time, call once per control tick before MotionAxis::tick()
+	void tick(unsigned long now);
+
+private:
+	MotionAxis *_motion;
+	uint8_t _seed;
+
+	// One array per field like MotionAxis
+	uint8_t _count = 0;
+	uint8_t _axis[MotionIdle_MAX_CHANNELS];
+	int32_t _center[MotionIdle_MAX_CHANNELS];
+	int32_t _amplitude[MotionIdle_MAX_CHANNELS];
+	uint32_t _step[MotionIdle_MAX_CHANNELS];        // Lattice steps per ms, Q24
+	int32_t _breathAmplitude[MotionIdle_MAX_CHANNELS];
+	uint32_t _breathStep[MotionIdle_MAX_CHANNELS];  // Breaths per ms, Q24
+	int32_t _offset[MotionIdle_MAX_CHANNELS];       // Offset written by the last tick
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef MotionMath_h
+#define MotionMath_h
+
+#include "Arduino.h"
+
+// Integer helpers for the servo motion path.
+// The ESP8266 has no FPU, every double operation is emulated in software,
+// so the per-loop easing code only uses the fixed-point formats below.
+//
+// Sub-ticks:  PCA9685 pulse ticks (0..4095) << MotionMath_SUBTICK_BITS.
+//             One tick is ~0.4 degree on a 150..595 servo, sub-ticks keep the easing smooth in between.
+// Q8:         Logical values (axis percent, degrees) << 8.
+// Q16:        Progress and easing factors, MotionMath_ONE equals 1.0.
+//
+// All products stay inside int32_t for the value ranges used here (pulse ranges up to 4096 ticks,
+// axis ranges up to +-200 in Q8), keep that in mind when mapping larger ranges.
+
+#define MotionMath_SUBTICK_BITS 4
+#define MotionMath_SUBTICKS_PER_TICK (1 << MotionMath_SUBTICK_BITS)
+#define MotionMath_Q8 8
+#define MotionMath_ONE 65536L // Q16 1.0
+
+// Whole value to Q8
+inline int32_t motionToQ8(int32_t value)
+{
+	return value * 256;
+}
+
+// Q8 to whole value, rounded
+inline int32_t motionFromQ8(int32_t value)
+{
+	return (value + 128) >> MotionMath_Q8;
+}
+
+// Pulse ticks to sub-ticks
+inline int32_t motionTicksToSubticks(int32_t ticks)
+{
+	return ticks << MotionMath_SUBTICK_BITS;
+}
+
+// Sub-ticks to the pulse length sent to the PCA9685, rounded
+inline uint16_t motionSubticksToPulse(int32_t subticks)
+{
+	return (uint16_t)((subticks + (MotionMath_SUBTICKS_PER_TICK / 2)) >> MotionMath_SUBTICK_BITS);
+}
+
+// Integer version of Arduino map() without the truncation to whole output units
+inline int32_t motionMap(int32_t value, int32_t inMin, int32_t inMax, int32_t outMin, int32_t outMax)
+{
+	return (value - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Servo angle in Q8 degrees (0..180) to sub-ticks between servoMin and servoMax
+inline int32_t motionDegreeQ8ToSubticks(int32_t degreeQ8, int32_t servoMin, int32_t servoMax)
+{
+	return motionTicksToSubticks(servoMin) + degreeQ8 * ((servoMax - servoMin) * MotionMath_SUBTICKS_PER_TICK) / motionToQ8(180);
+}
+
+// Elapsed time as Q16 progress of a movement, clamped to 0..1
+inline uint32_t motionProgress(unsigned long elapsed, unsigned long duration)
+{
+	if (duration == 0 || elapsed >= duration)
+	{
+		return MotionMath_ONE;
+	}
+	// Scale both down for moves longer than 65 seconds so (elapsed << 16) stays inside 32 bit
+	while (elapsed >= 65536UL)
+	{
+		elapsed >>= 1;
+		duration >>= 1;
+	}
+	return (uint32_t)((elapsed << 16) / duration);
+}
+
+// Ease-in-out quadratic on Q16 progress: 2t^2 for the first half, 1 - 2(1-t)^2 for the second
+inline uint32_t motionEaseInOutQuad(uint32_t t)
+{
+	if (t >= (uint32_t)MotionMath_ONE)
+	{
+		return MotionMath_ONE;
+	}
+	if (t < (uint32_t)(MotionMath_ONE / 2))
+	{
+		return (t * t) >> 15;
+	}
+	uint32_t u = MotionMath_ONE - t;
+	return MotionMath_ONE - ((u * u) >> 15);
+}
+
+// Integer square root, rounded down. Bit by bit, so only use it when a move is planned or its input changed, not per tick
+inline uint32_t motionSqrt(uint64_t value)
+{
+	uint64_t result = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > value)
+	{
+		bit >>= 2;
+	}
+	while (bit != 0)
+	{
+		if (value >= result + bit)
+		{
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)result;
+}
+
+// Position between start and target for a Q16 factor, factors outside 0..1 overshoot
+inline int32_t motionLerp(int32_t start, int32_t target, int32_t factor)
+{
+	return start + (int32_t)(((int64_t)(target - start) * factor) >> 16);
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "PoseLibrary.h"
+
+static uint32_t PoseLibrary_offset(uint8_t slot)
+{
+	return PoseLibrary_HEADER_SIZE + (uint32_t)slot * sizeof(PoseLibrary::Pose);
+}
+
+bool PoseLibrary::begin()
+{
+	memset(_names, 0, sizeof(_names));
+
+	File file = LittleFS.open(PoseLibrary_FILE, "r");
+	char magic[PoseLibrary_HEADER_SIZE];
+	if (!file || file.read((uint8_t *)magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, PoseLibrary_MAGIC, sizeof(magic)) != 0 ||
+		file.size() != PoseLibrary_offset(PoseLibrary_MAX_POSES))
+	{
+		if (file)
+		{
+			file.close();
+		}
+
+		// Missing or from another version: start with empty slots
+		file = LittleFS.open(PoseLibrary_FILE, "w");
+		if (!file)
+		{
+			Serial.println("PoseLibrary: cannot create " PoseLibrary_FILE);
+			return false;
+		}
+		Pose empty;
+		memset(&empty, 0, sizeof(empty));
+		file.write((const uint8_t *)PoseLibrary_MAGIC, PoseLibrary_HEADER_SIZE);
+		for (uint8_t slot = 0; slot < PoseLibrary_MAX_POSES; slot++)
+		{
+			file.write((const uint8_t *)&empty, sizeof(empty));
+		}
+		file.close();
+		return true;
+	}
+
+	// Only the names stay in RAM
+	for (uint8_t slot = 0; slot < PoseLibrary_MAX_POSES; slot++)
+	{
+		file.seek(PoseLibrary_offset(slot));
+		file.read((uint8_t *)_names[slot], PoseLibrary_NAME_SIZE);
+		_names[slot][PoseLibrary_NAME_SIZE - 1] = 0;
+	}
+	file.close();
+	return true;
+}
+
+bool PoseLibrary::recall(const char *name, Pose &pose)
+{
+	int8_t slot = find(name);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	File file = LittleFS.open(PoseLibrary_FILE, "r");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = file.seek(PoseLibrary_offset(slot)) && file.read((uint8_t *)&pose, sizeof(pose)) == sizeof(pose);
+	file.close();
+	return ok;
+}
+
+bool PoseLibrary::save(const char *name, const Pose &pose)
+{
+	if (name == nullptr || name[0] == 0)
+	{
+		return false;
+	}
+
+	int8_t slot = find(name);
+	for (uint8_t free = 0; slot < 0 && free < PoseLibrary_MAX_POSES; free++)
+	{
+		if (_names[free][0] == 0)
+		{
+			slot = free;
+		}
+	}
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	Pose stored = pose;
+	memset(stored.name, 0, sizeof(stored.name));
+	strlcpy(stored.name, name, sizeof(stored.name));
+	if (writeSlot(slot, stored) == false)
+	{
+		return false;
+	}
+	memcpy(_names[slot], stored.name, PoseLibrary_NAME_SIZE);
+	return true;
+}
+
+bool PoseLibrary::remove(const char *name)
+{
+	int8_t slot = find(name);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	Pose empty;
+	memset(&empty, 0, sizeof(empty));
+	if (writeSlot(slot, empty) == false)
+	{
+		return false;
+	}
+	_names[slot][0] = 0;
+	return true;
+}
+
+const char *PoseLibrary::name(uint8_t slot)
+{
+	return slot < PoseLibrary_MAX_POSES && _names[slot][0] != 0 ? _names[slot] : nullptr;
+}
+
+int8_t PoseLibrary::find(const char *name)
+{
+	if (name == nullptr || name[0] == 0)
+	{
+		return -1;
+	}
+	for (uint8_t slot = 0; slot < PoseLibrary_MAX_POSES; slot++)
+	{
+		if (strncmp(_names[slot], name, PoseLibrary_NAME_SIZE - 1) == 0)
+		{
+			return slot;
+		}
+	}
+	return -1;
+}
+
+// Overwrites one slot in place, the rest of the file is not touched
+bool PoseLibrary::writeSlot(uint8_t slot, const Pose &pose)
+{
+	File file = LittleFS.open(PoseLibrary_FILE, "r+");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = file.seek(PoseLibrary_offset(slot)) && file.write((const uint8_t *)&pose, sizeof(pose)) == sizeof(pose);
+	file.close();
+	return ok;
+}
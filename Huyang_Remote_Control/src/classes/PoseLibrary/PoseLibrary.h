@@ -0,0 +1,56 @@
+#ifndef PoseLibrary_h
+#define PoseLibrary_h
+
+#include "Arduino.h"
+#include "FS.h"
+#include "LittleFS.h"
+
+#define PoseLibrary_FILE "/poses.bin"
+#define PoseLibrary_MAGIC "HYP1"
+#define PoseLibrary_HEADER_SIZE 4
+#define PoseLibrary_MAX_POSES 16
+#define PoseLibrary_NAME_SIZE 16 // Including the terminating 0
+
+// Named poses of the whole droid, stored in one LittleFS file of fixed-size slots:
+// the magic "HYP1", then PoseLibrary_MAX_POSES Pose structs as they are in memory.
+// Only the names are kept in RAM, recall() finds the slot by name and reads that one struct,
+// so recalling a pose costs a single small flash read and no parsing.
+class PoseLibrary
+{
+public:
+	struct Pose
+	{
+		char name[PoseLibrary_NAME_SIZE]; // Empty = free slot
+		int16_t neckRotate;               // Slider units like the manual inputs, -100 to 100
+		int16_t neckTiltForward;
+		int16_t neckTiltSideways;
+		int16_t monocle;
+		int16_t bodyRotate;
+		int16_t bodyTiltForward;
+		int16_t bodyTiltSideways;
+		uint8_t leftEye;                  // Eye state number as on /api/post.json, 0 = leave as it is
+		uint8_t rightEye;
+		uint8_t lightMode;                // Chest light mode
+		uint8_t reserved;
+	};
+
+	// Opens or creates the pose file and reads the names, LittleFS has to be mounted
+	bool begin();
+
+	// Reads the pose with that name, false if there is none
+	bool recall(const char *name, Pose &pose);
+	// Stores a pose under a name, replaces a pose with the same name. False if all slots are taken.
+	bool save(const char *name, const Pose &pose);
+	bool remove(const char *name);
+
+	// Names for listing, nullptr for a free slot
+	const char *name(uint8_t slot);
+
+private:
+	char _names[PoseLibrary_MAX_POSES][PoseLibrary_NAME_SIZE];
+
+	int8_t find(const char *name);
+	bool writeSlot(uint8_t slot, const Pose &pose);
+};
+
+#endif
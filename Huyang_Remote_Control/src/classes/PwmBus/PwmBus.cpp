@@ -0,0 +1,288 @@
+#include "PwmBus.h"
+#include <Adafruit_PWMServoDriver.h>
+
+PwmBus::PwmBus(uint8_t boardsPerTick, uint16_t budgetMicros, TwoWire *wire)
+{
+	_wire = wire;
+	_boardsPerTick = max(boardsPerTick, (uint8_t)1);
+	_budgetMicros = budgetMicros;
+	resetCounters();
+}
+
+uint8_t PwmBus::addBoard(uint8_t address)
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		if (_address[board] == address)
+		{
+			return board;
+		}
+	}
+
+	if (_boardCount >= PwmBus_MAX_BOARDS)
+	{
+		return PwmBus_NO_CHANNEL;
+	}
+
+	_address[_boardCount] = address;
+	_frames[_boardCount] = new PwmFrame(address, _wire);
+	_waited[_boardCount] = 0;
+	return _boardCount++;
+}
+
+uint8_t PwmBus::channel(uint8_t address, uint8_t output)
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		if (_address[board] == address && output < PwmFrame_CHANNELS)
+		{
+			return PwmBus_CHANNEL(board, output);
+		}
+	}
+	return PwmBus_NO_CHANNEL;
+}
+
+uint8_t PwmBus::boardCount()
+{
+	return _boardCount;
+}
+
+void PwmBus::begin(float frequency, uint32_t clock)
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		Adafruit_PWMServoDriver driver(_address[board], *_wire);
+		driver.begin();
+		driver.setOscillatorFrequency(PwmBus_OSCILLATOR);
+		driver.setPWMFreq(frequency); // Also enables the register auto-increment the burst writes rely on
+	}
+
+	_wire->setClock(clock);
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->setClock(clock);
+	}
+
+	// The real period follows the prescaler the driver picked: 4096 oscillator cycles times (prescale + 1)
+	uint32_t prescale = (uint32_t)(PwmBus_OSCILLATOR / (4096.0f * frequency) + 0.5f);
+	_periodMicros = (unsigned long)((4096ULL * prescale * 1000000ULL) / PwmBus_OSCILLATOR);
+	_nextFlushMicros = micros();
+}
+
+// Frame of the board a logical channel belongs to, nullptr for channels of unregistered boards
+PwmFrame *PwmBus::frame(uint8_t channel)
+{
+	uint8_t board = channel / PwmFrame_CHANNELS;
+	return board < _boardCount ? _frames[board] : nullptr;
+}
+
+void PwmBus::setPWM(uint8_t channel, uint16_t pulselength)
+{
+	PwmFrame *target = frame(channel);
+	if (target != nullptr)
+	{
+		target->setPWM(channel % PwmFrame_CHANNELS, pulselength);
+	}
+}
+
+void PwmBus::setServo(uint8_t channel, int32_t subticks)
+{
+	PwmFrame *target = frame(channel);
+	if (target != nullptr)
+	{
+		target->setServo(channel % PwmFrame_CHANNELS, subticks);
+	}
+}
+
+uint16_t PwmBus::getPWM(uint8_t channel)
+{
+	PwmFrame *target = frame(channel);
+	return target != nullptr ? target->getPWM(channel % PwmFrame_CHANNELS) : 0;
+}
+
+bool PwmBus::isReleased(uint8_t channel)
+{
+	PwmFrame *target = frame(channel);
+	return target != nullptr && target->isReleased(channel % PwmFrame_CHANNELS);
+}
+
+void PwmBus::refreshServos()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->refreshServos();
+	}
+}
+
+void PwmBus::centerServos()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->centerServos();
+	}
+}
+
+void PwmBus::setCalibration(ServoCalibration *calibration)
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->setCalibration(calibration, PwmBus_CHANNEL(board, 0));
+	}
+}
+
+void PwmBus::invalidate()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->invalidate();
+	}
+}
+
+void PwmBus::release(unsigned long now, unsigned long holdTime)
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->release(now, holdTime);
+	}
+}
+
+void PwmBus::releaseAll()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->releaseAll();
+	}
+}
+
+void PwmBus::hold()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		_frames[board]->hold();
+	}
+}
+
+void PwmBus::flush()
+{
+	// One flush per PWM period. The control tick may run early or late by up to a quarter period,
+	// the schedule keeps the phase so tick jitter does not add up.
+	unsigned long now = micros();
+	if (_periodMicros != 0)
+	{
+		long ahead = (long)(_nextFlushMicros - now);
+		if (ahead > (long)(_periodMicros / 4))
+		{
+			skippedFlushes++;
+			return;
+		}
+		_nextFlushMicros += _periodMicros;
+		if ((long)(_nextFlushMicros - now) < (long)(_periodMicros / 2))
+		{
+			_nextFlushMicros = now + _periodMicros; // Fell behind (blocking code), start a new schedule
+		}
+	}
+
+	// Most urgent board first until the board count or the time budget runs out.
+	// The search starts after the board sent last, so boards of equal urgency take turns.
+	uint16_t budget = _budgetMicros;
+	for (uint8_t sent = 0; sent < _boardsPerTick; sent++)
+	{
+		uint8_t worst = PwmBus_NO_CHANNEL;
+		uint32_t worstUrgency = 0;
+		for (uint8_t i = 0; i < _boardCount; i++)
+		{
+			uint8_t board = (_nextBoard + i) % _boardCount;
+			uint16_t error = _frames[board]->maxError();
+			uint32_t urgency = error != 0 ? error + (uint32_t)_waited[board] * PwmBus_AGING : 0;
+			if (urgency > worstUrgency)
+			{
+				worst = board;
+				worstUrgency = urgency;
+			}
+		}
+		if (worst == PwmBus_NO_CHANNEL)
+		{
+			break;
+		}
+
+		uint16_t used = flushBoard(worst, budget);
+		_waited[worst] = 0;
+		_nextBoard = (worst + 1) % _boardCount;
+		if (budget != PwmFrame_NO_BUDGET)
+		{
+			budget -= min(used, budget);
+		}
+		if (_frames[worst]->isDirty())
+		{
+			break; // Out of budget
+		}
+	}
+
+	// Only boards that still differ from their PCA9685 wait, not the ones that changed and went back
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		if (_frames[board]->maxError() != 0)
+		{
+			deferredFlushes++;
+			if (_waited[board] < 0xFF)
+			{
+				_waited[board]++;
+			}
+		}
+		else
+		{
+			_waited[board] = 0;
+		}
+	}
+
+	countBusTime(micros() - now);
+}
+
+void PwmBus::flushAll()
+{
+	for (uint8_t board = 0; board < _boardCount; board++)
+	{
+		flushBoard(board, PwmFrame_NO_BUDGET);
+	}
+}
+
+// Sends one board and moves its traffic into the counters of the bus
+uint16_t PwmBus::flushBoard(uint8_t board, uint16_t budgetMicros)
+{
+	PwmFrame *target = _frames[board];
+	uint16_t used = target->flush(budgetMicros);
+
+	transactions += target->transactions;
+	bytesWritten += target->bytesWritten;
+	channelWrites += target->channelWrites;
+	target->resetCounters();
+	return used;
+}
+
+void PwmBus::countBusTime(unsigned long elapsed)
+{
+	uint8_t bucket = 0;
+	for (unsigned long limit = PwmBus_HISTOGRAM_FIRST; elapsed >= limit && bucket < PwmBus_HISTOGRAM_BUCKETS - 1; limit <<= 1)
+	{
+		bucket++;
+	}
+	if (busTime[bucket] < 0xFFFF)
+	{
+		busTime[bucket]++;
+	}
+	maxBusTime = (uint16_t)min(max((unsigned long)maxBusTime, elapsed), 0xFFFFUL);
+}
+
+void PwmBus::resetCounters()
+{
+	transactions = 0;
+	bytesWritten = 0;
+	channelWrites = 0;
+	deferredFlushes = 0;
+	skippedFlushes = 0;
+	maxBusTime = 0;
+	for (uint8_t bucket = 0; bucket < PwmBus_HISTOGRAM_BUCKETS; bucket++)
+	{
+		busTime[bucket] = 0;
+	}
+}
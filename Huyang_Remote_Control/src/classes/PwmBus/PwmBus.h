@@ -0,0 +1,105 @@
+#ifndef PwmBus_h
+#define PwmBus_h
+
+#include "Arduino.h"
+#include <Wire.h>
+#include "../PwmFrame/PwmFrame.h"
+#include "../ServoCalibration/ServoCalibration.h"
+
+// Number of PCA9685 boards that can be registered, every board costs one PwmFrame
+#ifndef PwmBus_MAX_BOARDS
+#define PwmBus_MAX_BOARDS 2
+#endif
+
+#define PwmBus_NO_CHANNEL 0xFF
+
+// Bus time histogram of flush(): bucket 0 counts flushes under 125 us, every further bucket doubles the limit,
+// the last one counts everything from 8 ms up
+#define PwmBus_HISTOGRAM_BUCKETS 8
+#define PwmBus_HISTOGRAM_FIRST 125
+
+#define PwmBus_OSCILLATOR 27000000 // Internal PCA9685 oscillator in Hz
+
+// Pulse ticks of urgency a board with changes gains for every flush() it had to wait, like PwmFrame_AGING
+#define PwmBus_AGING 128
+
+// Logical channel of an output: board index (order of addBoard()) * 16 + output on that board
+#define PwmBus_CHANNEL(board, output) (uint8_t)((board) * PwmFrame_CHANNELS + (output))
+
+#if PwmBus_MAX_BOARDS * PwmFrame_CHANNELS > ServoCalibration_CHANNELS
+#error "ServoCalibration_CHANNELS must cover every channel of PwmBus_MAX_BOARDS boards"
+#endif
+
+// Registry of all PCA9685 boards on the I2C bus.
+// Axes, mixers and the calibration address servos by logical channel, the bus routes each channel
+// to the PwmFrame of its board. Writes are collected per board and flushed as bursts.
+//
+// flush() is the bus scheduler: it sends at most boardsPerTick boards and budgetMicros of estimated
+// I2C time per control tick, the board and channels furthest from their target first. Whatever does not
+// fit stays changed and competes again in the next flush() with PwmBus_AGING more urgency for every tick
+// it waited, boards of equal urgency take turns. So the I2C time of one tick is bounded no matter how many
+// servos move, and no board waits for long behind one that keeps moving. Flushes are paced to the PWM period of the boards: the PCA9685 outputs
+// one pulse per period, a second flush within the same period would never reach the servo.
+class PwmBus
+{
+public:
+	PwmBus(uint8_t boardsPerTick = 1, uint16_t budgetMicros = PwmFrame_NO_BUDGET, TwoWire *wire = &Wire);
+
+	// Registers a board and returns its index, the same index if the address is known already.
+	// PwmBus_NO_CHANNEL if all PwmBus_MAX_BOARDS boards are in use.
+	uint8_t addBoard(uint8_t address);
+	// Logical channel of an output on the board with that address, PwmBus_NO_CHANNEL for an unknown board
+	uint8_t channel(uint8_t address, uint8_t output);
+	uint8_t boardCount();
+	// Starts every registered board with the servo frequency (Hz) and sets the I2C clock (Hz),
+	// the PCA9685 runs up to 1 MHz if the wiring allows it
+	void begin(float frequency, uint32_t clock = 100000);
+
+	// Same as on PwmFrame, with logical channels
+	void setPWM(uint8_t channel, uint16_t pulselength);
+	void setServo(uint8_t channel, int32_t subticks);
+	uint16_t getPWM(uint8_t channel);
+	void refreshServos();
+	void centerServos();
+	void setCalibration(ServoCalibration *calibration);
+	void invalidate();
+	void release(unsigned long now, unsigned long holdTime);
+	void releaseAll();
+	void hold();
+	bool isReleased(uint8_t channel);
+
+	// Sends the most urgent changes within the budget, call once per control tick
+	void flush();
+	// Sends the changes of every board, for setup moves outside the control tick
+	void flushAll();
+
+	// Traffic counters of all boards, like the ones of PwmFrame
+	uint32_t transactions = 0;
+	uint32_t bytesWritten = 0;
+	uint32_t channelWrites = 0;
+	uint32_t deferredFlushes = 0; // Boards with changes that had to wait for the next tick
+	uint32_t skippedFlushes = 0;  // flush() calls in a PWM period that was already sent
+	uint16_t busTime[PwmBus_HISTOGRAM_BUCKETS]; // Measured I2C time of each flush(), see PwmBus_HISTOGRAM_FIRST
+	uint16_t maxBusTime = 0;      // Longest flush() in us
+	void resetCounters();
+
+private:
+	TwoWire *_wire;
+	uint8_t _boardsPerTick;
+	uint16_t _budgetMicros;
+
+	unsigned long _periodMicros = 0;    // PWM period of the boards, 0 until begin()
+	unsigned long _nextFlushMicros = 0; // Start of the next PWM period that gets a flush
+
+	uint8_t _boardCount = 0;
+	uint8_t _address[PwmBus_MAX_BOARDS];
+	PwmFrame *_frames[PwmBus_MAX_BOARDS];
+	uint8_t _waited[PwmBus_MAX_BOARDS]; // flush() calls the board had changes but was not sent
+	uint8_t _nextBoard = 0;             // Board after the last one sent, wins a tie
+
+	PwmFrame *frame(uint8_t channel);
+	uint16_t flushBoard(uint8_t board, uint16_t budgetMicros);
+	void countBusTime(unsigned long elapsed);
+};
+
+#endif
@@ -0,0 +1,316 @@
+#include "PwmFrame.h"
+#include <Wire.h>
+
+PwmFrame::PwmFrame(uint8_t address, TwoWire *wire)
+{
+	_address = address;
+	_wire = wire;
+
+	for (uint8_t channel = 0; channel < PwmFrame_CHANNELS; channel++)
+	{
+		_pulselength[channel] = 0;
+		_sent[channel] = PwmFrame_NOT_SENT;
+		_changedAt[channel] = 0;
+		_waited[channel] = 0;
+		_nominal[channel] = 0;
+	}
+}
+
+void PwmFrame::setPWM(uint8_t channel, uint16_t pulselength)
+{
+	if (channel >= PwmFrame_CHANNELS)
+	{
+		return;
+	}
+
+	uint16_t bit = (uint16_t)1 << channel;
+
+	// Unchanged channels stay clean and are skipped by the next flush
+	if ((_usedMask & bit) && _pulselength[channel] == pulselength)
+	{
+		return;
+	}
+
+	_pulselength[channel] = pulselength;
+	_usedMask |= bit;
+	_dirtyMask |= bit;
+	_changedMask |= bit;
+	_releasedMask &= ~bit; // A new position powers the servo again
+}
+
+void PwmFrame::setServo(uint8_t channel, int32_t subticks)
+{
+	if (channel >= PwmFrame_CHANNELS)
+	{
+		return;
+	}
+
+	uint16_t bit = (uint16_t)1 << channel;
+	if ((_servoMask & bit) && _nominal[channel] == subticks)
+	{
+		return;
+	}
+	_nominal[channel] = subticks;
+	_servoMask |= bit;
+
+	if (_calibration != nullptr)
+	{
+		subticks = _calibration->subticks(_calibrationChannel + channel, subticks);
+	}
+	setPWM(channel, motionSubticksToPulse(subticks));
+}
+
+void PwmFrame::setCalibration(ServoCalibration *calibration, uint8_t firstChannel)
+{
+	_calibration = calibration;
+	_calibrationChannel = firstChannel;
+	refreshServos();
+}
+
+void PwmFrame::refreshServos()
+{
+	_servoMask = 0;
+}
+
+void PwmFrame::centerServos()
+{
+	int32_t center = motionTicksToSubticks(ServoCalibration_NOMINAL_MIN + ServoCalibration_NOMINAL_MAX) / 2;
+	for (uint8_t channel = 0; channel < PwmFrame_CHANNELS; channel++)
+	{
+		if (_usedMask & ((uint16_t)1 << channel))
+		{
+			setServo(channel, center);
+		}
+	}
+}
+
+uint16_t PwmFrame::getPWM(uint8_t channel)
+{
+	if (channel >= PwmFrame_CHANNELS)
+	{
+		return 0;
+	}
+	return _pulselength[channel];
+}
+
+void PwmFrame::invalidate()
+{
+	_dirtyMask = _usedMask;
+	for (uint8_t channel = 0; channel < PwmFrame_CHANNELS; channel++)
+	{
+		_sent[channel] = PwmFrame_NOT_SENT;
+	}
+}
+
+void PwmFrame::release(unsigned long now, unsigned long holdTime)
+{
+	// Channels that changed since the last call start their hold time now
+	uint16_t changed = _changedMask;
+	_changedMask = 0;
+	for (uint8_t channel = 0; changed != 0; channel++, changed >>= 1)
+	{
+		if (changed & 1)
+		{
+			_changedAt[channel] = now;
+		}
+	}
+
+	if (holdTime == 0)
+	{
+		return;
+	}
+
+	uint16_t holding = _usedMask & ~_releasedMask;
+	for (uint8_t channel = 0; holding != 0; channel++, holding >>= 1)
+	{
+		if ((holding & 1) && now - _changedAt[channel] >= holdTime)
+		{
+			_releasedMask |= (uint16_t)1 << channel;
+			_dirtyMask |= (uint16_t)1 << channel;
+		}
+	}
+}
+
+void PwmFrame::releaseAll()
+{
+	_dirtyMask |= _usedMask & ~_releasedMask;
+	_releasedMask = _usedMask;
+}
+
+void PwmFrame::hold()
+{
+	_dirtyMask |= _releasedMask;
+	_changedMask |= _releasedMask; // The hold time starts again
+	_releasedMask = 0;
+}
+
+bool PwmFrame::isReleased(uint8_t channel)
+{
+	return channel < PwmFrame_CHANNELS && (_releasedMask & ((uint16_t)1 << channel)) != 0;
+}
+
+uint16_t PwmFrame::flush(uint16_t budgetMicros)
+{
+	uint16_t used = 0;
+
+	while (_dirtyMask != 0)
+	{
+		// Most urgent channel first, channels that waited catch up
+		uint8_t worst = 0;
+		uint32_t worstUrgency = 0;
+		for (uint8_t channel = 0; channel < PwmFrame_CHANNELS; channel++)
+		{
+			uint16_t bit = (uint16_t)1 << channel;
+			if ((_dirtyMask & bit) == 0)
+			{
+				continue;
+			}
+
+			uint16_t channelError = error(channel);
+			if (channelError == 0)
+			{
+				_dirtyMask &= ~bit; // Changed and back again, the PCA9685 already has it
+				_waited[channel] = 0;
+				continue;
+			}
+
+			uint32_t urgency = channelError + (uint32_t)_waited[channel] * PwmFrame_AGING;
+			if (urgency > worstUrgency)
+			{
+				worst = channel;
+				worstUrgency = urgency;
+			}
+		}
+		if (worstUrgency == 0)
+		{
+			break;
+		}
+
+		// Take the run of adjacent changed channels around it along, a channel more costs only 4 bytes
+		uint8_t first = worst;
+		uint8_t count = 1;
+		while (count < PwmFrame_MAX_BURST && first > 0 && (_dirtyMask & ((uint16_t)1 << (first - 1))))
+		{
+			first--;
+			count++;
+		}
+		while (count < PwmFrame_MAX_BURST && first + count < PwmFrame_CHANNELS && (_dirtyMask & ((uint16_t)1 << (first + count))))
+		{
+			count++;
+		}
+
+		uint16_t cost = burstMicros(count);
+		if (budgetMicros != PwmFrame_NO_BUDGET && used + cost > budgetMicros)
+		{
+			first = worst;
+			count = 1;
+			cost = burstMicros(1);
+			if (used + cost > budgetMicros)
+			{
+				break;
+			}
+		}
+
+		for (uint8_t i = 0; i < count; i++)
+		{
+			_dirtyMask &= ~((uint16_t)1 << (first + i));
+		}
+		writeBurst(first, count);
+		used += cost;
+	}
+
+	uint16_t waiting = _dirtyMask;
+	for (uint8_t channel = 0; waiting != 0; channel++, waiting >>= 1)
+	{
+		if ((waiting & 1) && _waited[channel] < 0xFF)
+		{
+			_waited[channel]++;
+		}
+	}
+
+	return used;
+}
+
+bool PwmFrame::isDirty()
+{
+	return _dirtyMask != 0;
+}
+
+uint16_t PwmFrame::maxError()
+{
+	uint16_t worstError = 0;
+	for (uint8_t channel = 0; channel < PwmFrame_CHANNELS; channel++)
+	{
+		uint16_t bit = (uint16_t)1 << channel;
+		if ((_dirtyMask & bit) == 0)
+		{
+			continue;
+		}
+
+		uint16_t channelError = error(channel);
+		if (channelError == 0)
+		{
+			_dirtyMask &= ~bit; // Changed and back again, nothing to send
+			_waited[channel] = 0;
+			continue;
+		}
+		worstError = max(worstError, channelError);
+	}
+	return worstError;
+}
+
+void PwmFrame::setClock(uint32_t clock)
+{
+	_byteMicrosQ8 = (uint16_t)((9UL * 1000000UL * 256UL) / max(clock, (uint32_t)100000));
+}
+
+// Distance between what the channel should output and what the PCA9685 outputs.
+// Switching a channel on or off is always more urgent than any move.
+uint16_t PwmFrame::error(uint8_t channel)
+{
+	uint16_t value = isReleased(channel) ? PwmFrame_FULL_OFF : _pulselength[channel];
+	uint16_t sent = _sent[channel];
+	if (sent == PwmFrame_NOT_SENT || (value == PwmFrame_FULL_OFF) != (sent == PwmFrame_FULL_OFF))
+	{
+		return value == sent ? 0 : PwmFrame_NOT_SENT - 1;
+	}
+	return value > sent ? value - sent : sent - value;
+}
+
+uint16_t PwmFrame::burstMicros(uint8_t count)
+{
+	return PwmFrame_TRANSACTION_MICROS + (uint16_t)(((uint32_t)(2 + 4 * count) * _byteMicrosQ8) >> 8);
+}
+
+// Writes `count` consecutive channels in one transaction.
+// Relies on the auto-increment bit in MODE1, which Adafruit_PWMServoDriver::setPWMFreq() enables.
+void PwmFrame::writeBurst(uint8_t firstChannel, uint8_t count)
+{
+	_wire->beginTransmission(_address);
+	_wire->write(PwmFrame_LED0_ON_L + 4 * firstChannel);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		uint16_t pulselength = isReleased(firstChannel + i) ? PwmFrame_FULL_OFF : _pulselength[firstChannel + i];
+
+		_wire->write((uint8_t)0);                    // ON_L
+		_wire->write((uint8_t)0);                    // ON_H
+		_wire->write((uint8_t)(pulselength & 0xFF)); // OFF_L
+		_wire->write((uint8_t)(pulselength >> 8));   // OFF_H
+		_sent[firstChannel + i] = pulselength;
+		_waited[firstChannel + i] = 0;
+	}
+
+	_wire->endTransmission();
+
+	transactions++;
+	bytesWritten += 1 + 4 * count;
+	channelWrites += count;
+}
+
+void PwmFrame::resetCounters()
+{
+	transactions = 0;
+	bytesWritten = 0;
+	channelWrites = 0;
+}
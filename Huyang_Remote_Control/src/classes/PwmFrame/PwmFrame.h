@@ -0,0 +1,105 @@
+#ifndef PwmFrame_h
+#define PwmFrame_h
+
+#include "Arduino.h"
+#include <Wire.h>
+#include "../ServoCalibration/ServoCalibration.h"
+
+// PCA9685 register layout
+#define PwmFrame_CHANNELS 16      // Number of PWM outputs on one PCA9685
+#define PwmFrame_LED0_ON_L 0x06   // First channel register, every channel uses 4 registers (ON_L, ON_H, OFF_L, OFF_H)
+#define PwmFrame_FULL_OFF 4096     // OFF value with the full-off bit set, the output stays low and the servo goes limp
+#define PwmFrame_NOT_SENT 0xFFFF   // Value a channel has on the PCA9685 before it is first sent
+#define PwmFrame_NO_BUDGET 0xFFFF  // flush() without a time limit
+
+// Estimated I2C time: a fixed overhead per transaction (start, address, stop and the Wire library)
+// plus 9 bit clocks per byte
+#define PwmFrame_TRANSACTION_MICROS 30
+
+// Pulse ticks of urgency a changed channel gains for every flush() it had to wait, so a channel with a small
+// error is sent after a few flushes even while others keep moving (a servo range is about 450 ticks)
+#define PwmFrame_AGING 128
+
+// Adjacent dirty channels are sent as one auto-increment burst.
+// One register byte + 4 bytes per channel must fit into the Wire buffer:
+// 7 channels = 29 bytes fits the 32 byte AVR buffer, the ESP8266 buffer (128 bytes) would allow all 16.
+#ifndef PwmFrame_MAX_BURST
+#define PwmFrame_MAX_BURST 7
+#endif
+
+class PwmFrame
+{
+public:
+	// Constructor: I2C address of the PCA9685 and the bus it is connected to
+	PwmFrame(uint8_t address = 0x40, TwoWire *wire = &Wire);
+
+	// Stores the pulse length for a channel. Nothing is sent until flush().
+	void setPWM(uint8_t channel, uint16_t pulselength);
+	// Stores a servo position in nominal sub-ticks (see ServoCalibration.h), translated by the calibration of the channel.
+	// Repeating the last position costs only a compare, stationary servos are not translated again.
+	void setServo(uint8_t channel, int32_t subticks);
+	// Translates every servo again on its next setServo(), call after the calibration changed
+	void refreshServos();
+	// Moves every servo channel used so far to 90 degrees
+	void centerServos();
+	// Per-channel pulse calibration used by setServo(), without one the nominal pulse is sent.
+	// firstChannel is the calibration channel of output 0, boards after the first one start at 16, 32 ...
+	void setCalibration(ServoCalibration *calibration, uint8_t firstChannel = 0);
+	// Last value stored for a channel
+	uint16_t getPWM(uint8_t channel);
+
+	// Marks every channel that was ever set as changed, so the next flush() resends them
+	void invalidate();
+
+	// Releasing a channel switches its output to full-off, the servo stops holding its position.
+	// A released channel is powered again as soon as it gets a different pulse or hold() is called.
+	// release() releases channels that have not changed for holdTime ms (0 = never), call once per control tick.
+	void release(unsigned long now, unsigned long holdTime);
+	void releaseAll();
+	// Powers every released channel again with its last pulse
+	void hold();
+	bool isReleased(uint8_t channel);
+	// Sends changed channels to the PCA9685, adjacent channels as one burst write.
+	// The channel that is furthest from its value on the PCA9685 goes first, channels that do not fit
+	// into budgetMicros stay changed for the next flush() and gain PwmFrame_AGING for every flush they wait.
+	// Returns the estimated I2C time used.
+	uint16_t flush(uint16_t budgetMicros = PwmFrame_NO_BUDGET);
+	// True if flush() has something to send
+	bool isDirty();
+	// Largest difference between a changed channel and its value on the PCA9685, in pulse ticks.
+	// Changed channels that are back at their value on the PCA9685 are no longer counted as changed.
+	uint16_t maxError();
+	// I2C clock in Hz the time estimates of flush() are based on
+	void setClock(uint32_t clock);
+
+	// Traffic counters, use them to compare I2C load between builds
+	uint32_t transactions = 0;  // I2C transactions sent
+	uint32_t bytesWritten = 0;  // Payload bytes sent (register address + channel data)
+	uint32_t channelWrites = 0; // Channels sent
+	void resetCounters();
+
+private:
+	TwoWire *_wire;
+	uint8_t _address;
+	ServoCalibration *_calibration = nullptr;
+	uint8_t _calibrationChannel = 0;
+
+	uint16_t _pulselength[PwmFrame_CHANNELS]; // Pending value per channel
+	uint16_t _sent[PwmFrame_CHANNELS];        // Value on the PCA9685 (PwmFrame_FULL_OFF when released)
+	uint16_t _byteMicrosQ8 = 23040;           // Q8 micros per byte, 100 kHz until setClock()
+	uint16_t _dirtyMask = 0;                  // Bit set = channel changed since the last flush
+	uint16_t _usedMask = 0;                   // Bit set = channel was set at least once
+	uint16_t _releasedMask = 0;               // Bit set = channel is switched to full-off
+	uint16_t _changedMask = 0;                // Bit set = channel changed since the last release()
+	unsigned long _changedAt[PwmFrame_CHANNELS]; // Time of the last change, kept by release()
+	uint8_t _waited[PwmFrame_CHANNELS];       // flush() calls the changed channel was left out of
+
+	int32_t _nominal[PwmFrame_CHANNELS];      // Last position given to setServo()
+	uint16_t _servoMask = 0;                  // Bit set = _nominal is valid
+
+	uint16_t error(uint8_t channel);
+	uint16_t burstMicros(uint8_t count);
+	void writeBurst(uint8_t firstChannel, uint8_t count);
+};
+
+#endif
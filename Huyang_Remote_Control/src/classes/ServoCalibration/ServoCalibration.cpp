@@ -0,0 +1,126 @@
+#include "ServoCalibration.h"
+
+ServoCalibration::ServoCalibration()
+{
+	reset();
+	update();
+}
+
+bool ServoCalibration::set(uint8_t channel, Channel values)
+{
+	if (channel >= ServoCalibration_CHANNELS || isValid(values) == false)
+	{
+		return false;
+	}
+
+	_min[channel] = values.min;
+	_center[channel] = values.center;
+	_max[channel] = values.max;
+	_curve[channel] = constrain(values.curve, -ServoCalibration_MAX_CURVE, ServoCalibration_MAX_CURVE);
+	_changedMask |= (uint32_t)1 << channel;
+	return true;
+}
+
+ServoCalibration::Channel ServoCalibration::get(uint8_t channel)
+{
+	Channel values = defaults();
+	if (channel < ServoCalibration_CHANNELS)
+	{
+		values.min = _min[channel];
+		values.center = _center[channel];
+		values.max = _max[channel];
+		values.curve = _curve[channel];
+	}
+	return values;
+}
+
+ServoCalibration::Channel ServoCalibration::defaults()
+{
+	Channel values;
+	values.min = ServoCalibration_NOMINAL_MIN;
+	values.center = (ServoCalibration_NOMINAL_MIN + ServoCalibration_NOMINAL_MAX) / 2;
+	values.max = ServoCalibration_NOMINAL_MAX;
+	values.curve = 0;
+	return values;
+}
+
+bool ServoCalibration::isDefault(uint8_t channel)
+{
+	Channel values = defaults();
+	return _min[channel] == values.min && _center[channel] == values.center && _max[channel] == values.max && _curve[channel] == values.curve;
+}
+
+bool ServoCalibration::isValid(Channel values)
+{
+	return values.min > 0 && values.min < values.center && values.center < values.max && values.max <= ServoCalibration_MAX_PULSE;
+}
+
+void ServoCalibration::reset()
+{
+	for (uint8_t channel = 0; channel < ServoCalibration_CHANNELS; channel++)
+	{
+		set(channel, defaults());
+	}
+}
+
+bool ServoCalibration::update()
+{
+	uint32_t changed = _changedMask;
+	if (changed == 0)
+	{
+		return false;
+	}
+	_changedMask &= ~changed;
+
+	for (uint8_t channel = 0; channel < ServoCalibration_CHANNELS; channel++)
+	{
+		if (changed & ((uint32_t)1 << channel))
+		{
+			build(channel);
+		}
+	}
+	return true;
+}
+
+// Two linear halves through min, center and max, each bent by the curve as a parabola that is 0 at its ends
+void ServoCalibration::build(uint8_t channel)
+{
+	const uint8_t half = ServoCalibration_SEGMENTS / 2;
+	int32_t min = motionTicksToSubticks(_min[channel]);
+	int32_t center = motionTicksToSubticks(_center[channel]);
+	int32_t max = motionTicksToSubticks(_max[channel]);
+
+	for (uint8_t point = 0; point < ServoCalibration_POINTS; point++)
+	{
+		bool lower = point <= half;
+		int32_t from = lower ? min : center;
+		int32_t to = lower ? center : max;
+		int32_t step = lower ? point : point - half; // 0 to half inside the half
+
+		int32_t linear = from + (to - from) * step / half;
+		// 4u(1-u) is 1 in the middle of the half, there the pulse moves by curve percent of the half range
+		int32_t bend = (to - from) * _curve[channel] / 100 * 4 * step * (half - step) / (half * half);
+		_table[channel][point] = linear + bend;
+	}
+}
+
+int32_t ServoCalibration::subticks(uint8_t channel, int32_t nominal)
+{
+	if (channel >= ServoCalibration_CHANNELS)
+	{
+		return nominal;
+	}
+
+	int32_t offset = nominal - motionTicksToSubticks(ServoCalibration_NOMINAL_MIN);
+	offset = constrain(offset, 0, motionTicksToSubticks(ServoCalibration_NOMINAL_MAX - ServoCalibration_NOMINAL_MIN));
+	uint32_t position = ((uint32_t)offset * ServoCalibration_SCALE) >> 8; // Q16 table position
+	uint32_t index = position >> 16;
+
+	const int32_t *table = _table[channel];
+	if (index >= ServoCalibration_SEGMENTS)
+	{
+		return table[ServoCalibration_SEGMENTS];
+	}
+	int32_t fraction = position & 0xFFFF;
+	return table[index] + (int32_t)(((int64_t)(table[index + 1] - table[index]) * fraction) >> 16);
+}
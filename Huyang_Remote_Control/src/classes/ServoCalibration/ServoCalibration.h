@@ -0,0 +1,70 @@
+#ifndef ServoCalibration_h
+#define ServoCalibration_h
+
+#include "Arduino.h"
+#include "../MotionMath/MotionMath.h"
+
+#define ServoCalibration_CHANNELS 32 // Two PCA9685 boards, see PwmBus_MAX_BOARDS
+
+// Nominal pulse range every subsystem calculates with, 0 to 180 degrees on an ideal servo.
+// Sub-tick positions on this scale are translated into the real pulses of each servo.
+#define ServoCalibration_NOMINAL_MIN 150
+#define ServoCalibration_NOMINAL_MAX 595
+
+#define ServoCalibration_MAX_PULSE 4095 // Largest OFF value of a PCA9685 channel, 4096 switches it off
+#define ServoCalibration_MAX_CURVE 20   // Percent, more would let the pulse run backwards
+#define ServoCalibration_SEGMENT_BITS 4 // 16 segments per channel table
+#define ServoCalibration_SEGMENTS (1 << ServoCalibration_SEGMENT_BITS)
+#define ServoCalibration_POINTS (ServoCalibration_SEGMENTS + 1)
+
+// Q24 table segments per nominal sub-tick, a constant so the lookup needs no division
+#define ServoCalibration_SCALE (((uint32_t)ServoCalibration_SEGMENTS << 24) / ((ServoCalibration_NOMINAL_MAX - ServoCalibration_NOMINAL_MIN) << MotionMath_SUBTICK_BITS))
+
+// Pulse calibration of every PWM channel.
+// Each servo gets its own pulse at 0, 90 and 180 degrees and a curve for servos that do not turn linear to their pulse:
+// the pulse at 45 and 135 degrees is moved by curve percent of the half range. set() only stores the values,
+// update() compiles changed channels into a lookup table from the nominal scale to real sub-ticks,
+// so the per-tick translation in subticks() is a single table read with interpolation.
+class ServoCalibration
+{
+public:
+	struct Channel
+	{
+		uint16_t min;    // Pulse at 0 degrees
+		uint16_t center; // Pulse at 90 degrees
+		uint16_t max;    // Pulse at 180 degrees
+		int8_t curve;    // -ServoCalibration_MAX_CURVE to ServoCalibration_MAX_CURVE percent
+	};
+
+	ServoCalibration();
+
+	// Stores new values for a channel, they are used after the next update().
+	// Values that are not isValid() are rejected and the channel keeps its calibration, returns false then.
+	bool set(uint8_t channel, Channel values);
+	Channel get(uint8_t channel);
+	// Values of a servo that matches the nominal scale
+	Channel defaults();
+	bool isDefault(uint8_t channel);
+	// min < center < max within the PCA9685 pulse range, anything else would invert the servo or drive it to an end stop
+	static bool isValid(Channel values);
+	void reset();
+
+	// Rebuilds the tables of changed channels, call from the control tick. Returns true if a table changed.
+	bool update();
+
+	// Translates a nominal sub-tick position into the sub-ticks of the servo on that channel
+	int32_t subticks(uint8_t channel, int32_t nominal);
+
+private:
+	uint16_t _min[ServoCalibration_CHANNELS];
+	uint16_t _center[ServoCalibration_CHANNELS];
+	uint16_t _max[ServoCalibration_CHANNELS];
+	int8_t _curve[ServoCalibration_CHANNELS];
+	volatile uint32_t _changedMask = 0; // Set by the web server, cleared by update() in the control tick
+
+	int32_t _table[ServoCalibration_CHANNELS][ServoCalibration_POINTS];
+
+	void build(uint8_t channel);
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "ServoMixer.h"
+
+ServoMixer::ServoMixer(PwmBus *bus)
+{
+	_bus = bus;
+}
+
+void ServoMixer::build(const Input *inputs, uint8_t inputCount,
+					   const Servo *servos, uint8_t servoCount,
+					   const Link *links, uint8_t linkCount,
+					   uint16_t pulseMin, uint16_t pulseMax)
+{
+	_inputCount = min(inputCount, (uint8_t)ServoMixer_MAX_INPUTS);
+	_servoCount = min(servoCount, (uint8_t)ServoMixer_MAX_SERVOS);
+	_linkCount = min(linkCount, (uint8_t)ServoMixer_MAX_LINKS);
+	if (_inputCount < inputCount || _servoCount < servoCount || _linkCount < linkCount)
+	{
+		Serial.println("ServoMixer: linkage too large, increase ServoMixer_MAX_INPUTS/SERVOS/LINKS");
+	}
+
+	for (uint8_t input = 0; input < _inputCount; input++)
+	{
+		_inputMin[input] = motionToQ8(inputs[input].min);
+		_inputMax[input] = motionToQ8(inputs[input].max);
+		_inputScale[input] = tableScale(_inputMax[input] - _inputMin[input]);
+	}
+
+	// Angles become nominal sub-ticks, the calibration of each channel is applied by the PWM bus
+	_pulseMin = motionTicksToSubticks(pulseMin);
+	_pulseScale = ((uint32_t)motionTicksToSubticks(pulseMax - pulseMin) << 16) / motionToQ8(180);
+	for (uint8_t servo = 0; servo < _servoCount; servo++)
+	{
+		_channel[servo] = servos[servo].channel;
+		_minDegree[servo] = servos[servo].minDegree;
+		_maxDegree[servo] = servos[servo].maxDegree;
+		_degree[servo] = _minDegree[servo];
+	}
+
+	for (uint8_t link = 0; link < _linkCount; link++)
+	{
+		_linkServo[link] = links[link].servo;
+		_linkInput[link] = links[link].input;
+		for (uint8_t point = 0; point < ServoMixer_POINTS; point++)
+		{
+			_linkDegree[link][point] = motionMap(point, 0, ServoMixer_SEGMENTS, links[link].degreeAtMin, links[link].degreeAtMax);
+		}
+	}
+}
+
+// Q24 table segments per Q8 unit of a range, computed once so a lookup needs no division
+uint32_t ServoMixer::tableScale(int32_t range)
+{
+	return range > 0 ? ((uint32_t)ServoMixer_SEGMENTS << 24) / range : 0;
+}
+
+// Linear interpolation in a table that spans min to max, values outside are held at the ends
+int32_t ServoMixer::lookup(const int32_t *table, int32_t value, int32_t min, int32_t max, uint32_t scale)
+{
+	value = constrain(value, min, max);
+	uint32_t position = ((uint32_t)(value - min) * scale) >> 8; // Q16 table position
+	uint32_t index = position >> 16;
+	if (index >= ServoMixer_SEGMENTS)
+	{
+		return table[ServoMixer_SEGMENTS];
+	}
+	int32_t fraction = position & 0xFFFF;
+	return table[index] + (int32_t)(((int64_t)(table[index + 1] - table[index]) * fraction) >> 16);
+}
+
+void ServoMixer::update(const int32_t *inputs, uint8_t servoMask)
+{
+	int32_t degrees[ServoMixer_MAX_SERVOS] = {0};
+	for (uint8_t link = 0; link < _linkCount; link++)
+	{
+		uint8_t input = _linkInput[link];
+		degrees[_linkServo[link]] += lookup(_linkDegree[link], inputs[input], _inputMin[input], _inputMax[input], _inputScale[input]);
+	}
+
+	for (uint8_t servo = 0; servo < _servoCount; servo++)
+	{
+		if ((servoMask & (1 << servo)) == 0)
+		{
+			continue;
+		}
+
+		int32_t degree = constrain(degrees[servo], _minDegree[servo], _maxDegree[servo]);
+		_degree[servo] = degree;
+		// Unchanged values are skipped when the bus is flushed
+		_bus->setServo(_channel[servo], _pulseMin + (int32_t)(((int64_t)degree * _pulseScale) >> 16));
+	}
+}
+
+int32_t ServoMixer::degree(uint8_t servo)
+{
+	return _degree[servo];
+}
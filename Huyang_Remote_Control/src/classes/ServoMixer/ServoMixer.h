@@ -0,0 +1,97 @@
+#ifndef ServoMixer_h
+#define ServoMixer_h
+
+#include "Arduino.h"
+#include "../PwmBus/PwmBus.h"
+#include "../MotionMath/MotionMath.h"
+
+#define ServoMixer_MAX_INPUTS 4
+#define ServoMixer_MAX_SERVOS 4
+#define ServoMixer_MAX_LINKS 8
+#define ServoMixer_SEGMENT_BITS 4 // 16 segments per table
+#define ServoMixer_SEGMENTS (1 << ServoMixer_SEGMENT_BITS)
+#define ServoMixer_POINTS (ServoMixer_SEGMENTS + 1)
+
+// Servo angle for the tables below, written in degrees (fractions allowed), stored as Q8
+#define ServoMixer_DEGREE(degree) ((int32_t)((degree) * 256))
+
+// Mixes the axes of one servo group (neck tilt, body tilt) into its servos.
+// The linkage is declared as data: every link adds the angle one input gives one servo, the angles of all links of
+// a servo are summed and limited to its range. build() compiles the links into small lookup tables once, so update()
+// only needs table lookups, multiplications and shifts per servo, no divisions and no map() chains.
+// The angles are sent as nominal pulses, PwmFrame::setServo() applies the calibration of each channel.
+// A new linkage is a new row in the tables of its owner, not new code.
+class ServoMixer
+{
+public:
+	// Range of an input in axis units (-100 to 100 style, not Q8), the tables cover exactly this range
+	struct Input
+	{
+		int16_t min;
+		int16_t max;
+	};
+
+	// A servo of the group and the angle range it may move in
+	struct Servo
+	{
+		uint8_t channel;
+		int32_t minDegree; // ServoMixer_DEGREE()
+		int32_t maxDegree;
+	};
+
+	// Angle that an input adds to a servo, linear from the input minimum to its maximum
+	struct Link
+	{
+		uint8_t servo; // Index in the servo table
+		uint8_t input; // Index in the input table
+		int32_t degreeAtMin; // ServoMixer_DEGREE()
+		int32_t degreeAtMax;
+	};
+
+	ServoMixer(PwmBus *bus);
+
+	// Compiles the declared linkage for servos with the given nominal pulse range (PCA9685 ticks at 0 and 180 degrees)
+	void build(const Input *inputs, uint8_t inputCount,
+			   const Servo *servos, uint8_t servoCount,
+			   const Link *links, uint8_t linkCount,
+			   uint16_t pulseMin, uint16_t pulseMax);
+
+	// Mixes the Q8 input values (same order as the input table) and stores the servo pulses on the PWM bus.
+	// Only servos with their bit set in servoMask are written, e.g. to power them up one group after another.
+	void update(const int32_t *inputs, uint8_t servoMask = 0xFF);
+
+	// Angle of a servo after the last update in Q8 degrees
+	int32_t degree(uint8_t servo);
+
+private:
+	PwmBus *_bus;
+
+	uint8_t _inputCount = 0;
+	uint8_t _servoCount = 0;
+	uint8_t _linkCount = 0;
+
+	// Inputs: Q8 start of the table and Q24 table segments per Q8 unit
+	int32_t _inputMin[ServoMixer_MAX_INPUTS];
+	int32_t _inputMax[ServoMixer_MAX_INPUTS];
+	uint32_t _inputScale[ServoMixer_MAX_INPUTS];
+
+	// Servos: channel and angle limits
+	uint8_t _channel[ServoMixer_MAX_SERVOS];
+	int32_t _minDegree[ServoMixer_MAX_SERVOS];
+	int32_t _maxDegree[ServoMixer_MAX_SERVOS];
+	int32_t _degree[ServoMixer_MAX_SERVOS];
+
+	// Nominal sub-ticks at 0 degrees and Q16 sub-ticks per Q8 degree
+	int32_t _pulseMin;
+	uint32_t _pulseScale;
+
+	// Links: Q8 angle per input table point
+	uint8_t _linkServo[ServoMixer_MAX_LINKS];
+	uint8_t _linkInput[ServoMixer_MAX_LINKS];
+	int32_t _linkDegree[ServoMixer_MAX_LINKS][ServoMixer_POINTS];
+
+	static uint32_t tableScale(int32_t range);
+	static int32_t lookup(const int32_t *table, int32_t value, int32_t min, int32_t max, uint32_t scale);
+};
+
+#endif
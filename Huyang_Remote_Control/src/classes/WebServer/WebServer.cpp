@@ -15,9 +15,9 @@ uint16_t faceLeftEyeState = 3;  // Default to blink (state 3)
 uint16_t faceRightEyeState = 3; // Default to blink (state 3)
 
 // Neck movement values
-double neckRotate = 0;
-double neckTiltForward = 0;
-double neckTiltSideways = 0;
+int16_t neckRotate = 0;
+int16_t neckTiltForward = 0;
+int16_t neckTiltSideways = 0;
 
 // Body movement values
 int16_t bodyRotate = 0;
@@ -26,6 +26,40 @@ int16_t bodyTiltSideways = 0;
 
 int16_t monoclePosition = 0; // Monocle servo position
 
+// Look-at point, off until the first lookAt command
+bool lookAtActive = false;
+int16_t lookAtX = 0;
+int16_t lookAtY = 0;
+int16_t lookAtZ = 1000;
+
+// Clip sequencer
+ClipCommand clipCommand = CLIP_NONE;
+char clipPath[32] = "";
+bool clipLoop = false;
+uint16_t clipSpeed = 100;
+uint32_t clipSeekTime = 0;
+bool clipPlaying = false;
+
+// Pose library
+PoseCommand poseCommand = POSE_NONE;
+char poseName[PoseLibrary_NAME_SIZE] = "";
+uint16_t poseDuration = 1000;
+
+// Gesture generator
+GestureCommand gestureCommand = GESTURE_NONE;
+char gestureName[16] = "";
+int16_t gestureAmplitude = 0;
+uint16_t gestureFrequency = 0;
+uint8_t gestureCount = 0;
+bool gestureActive = false;
+
+// Servo model
+int16_t estimatedPose[6] = {0, 0, 0, 0, 0, 0};
+
+// Servo lock
+ServoCommand servoCommand = SERVO_NONE;
+ServoState servoState = SERVOS_ACTIVE;
+
 // Calibration values (defaults, loaded from file if present)
 int16_t calNeckRotation = 0;
 int16_t calNeckTiltForward = 0;
@@ -140,6 +174,9 @@ void WebServer::loadCalibration() {
       calBodyTiltSideways = doc["body"]["tiltSideways"] | 0;
       calMonoclePosition = doc["monocle"]["position"] | 0; 
 
+      servoCalibration->reset();
+      readServoCalibration(doc["servos"].as<JsonArrayConst>());
+
       Serial.printf("Loaded Calibration: Neck R:%d, TF:%d, TS:%d; Body R:%d, TF:%d, TS:%d; Monocle P:%d\n", 
                     calNeckRotation, calNeckTiltForward, calNeckTiltSideways,
                     calBodyRotation, calBodyTiltForward, calBodyTiltSideways,
@@ -166,6 +203,7 @@ void WebServer::saveCalibration() {
   doc["body"]["tiltForward"] = calBodyTiltForward;
   doc["body"]["tiltSideways"] = calBodyTiltSideways;
   doc["monocle"]["position"] = calMonoclePosition; 
+  writeServoCalibration(doc, true); // Channels that differ from the defaults
 
   String output;
   serializeJson(doc, output); 
@@ -182,9 +220,48 @@ void WebServer::resetCalibrationToDefaults() {
   calBodyTiltForward = 0;
   calBodyTiltSideways = 0;
   calMonoclePosition = 0; 
+  servoCalibration->reset();
   saveCalibration(); 
 }
 
+// Stores the calibration of the listed channels, missing fields keep their current value.
+// A channel whose pulses are not in order (see ServoCalibration::isValid()) keeps its calibration.
+// The tables are rebuilt by the next control tick.
+void WebServer::readServoCalibration(JsonArrayConst servos) {
+  for (JsonObjectConst servo : servos) {
+    if (!servo.containsKey("channel")) {
+      continue;
+    }
+    uint8_t channel = servo["channel"].as<uint8_t>();
+    ServoCalibration::Channel values = servoCalibration->get(channel);
+    values.min = servo["min"] | values.min;
+    values.center = servo["center"] | values.center;
+    values.max = servo["max"] | values.max;
+    values.curve = servo["curve"] | values.curve;
+    if (!servoCalibration->set(channel, values)) {
+      Serial.printf("Servo %d: rejected min %d, center %d, max %d, needs 0 < min < center < max <= %d\n", channel, values.min, values.center, values.max, ServoCalibration_MAX_PULSE);
+      continue;
+    }
+    Serial.printf("Calibrating Servo %d: min %d, center %d, max %d, curve %d\n", channel, values.min, values.center, values.max, values.curve);
+  }
+}
+
+void WebServer::writeServoCalibration(JsonDocument &doc, bool onlyChanged) {
+  JsonArray servos = doc["servos"].to<JsonArray>();
+  for (uint8_t channel = 0; channel < ServoCalibration_CHANNELS; channel++) {
+    if (onlyChanged && servoCalibration->isDefault(channel)) {
+      continue;
+    }
+    ServoCalibration::Channel values = servoCalibration->get(channel);
+    JsonObject servo = servos.add<JsonObject>();
+    servo["channel"] = channel;
+    servo["min"] = values.min;
+    servo["center"] = values.center;
+    servo["max"] = values.max;
+    servo["curve"] = values.curve;
+  }
+}
+
 // Starts the web server and defines all its routes (API endpoints and static files).
 void WebServer::start()
 {
@@ -313,50 +390,169 @@ void WebServer::apiPostAction(AsyncWebServerRequest *request, uint8_t *data, siz
         }
   }
 
-  if (json.containsKey("neck") && !json["neck"].isNull())
+  // Joystick packets stamped by the client are played out smoothly by the control tick instead of being applied as they land,
+  // e.g. {"seq": 12, "t": 53120, "neck": {"rotate": 40, "tiltForward": -10, "tiltSideways": 0}}
+  bool stamped = json.containsKey("seq") && json.containsKey("t");
+
+  if (stamped && json.containsKey("neck") && !json["neck"].isNull())
+  {
+    int16_t values[InputPlayout_VALUES] = {json["neck"]["rotate"] | neckRotate, json["neck"]["tiltForward"] | neckTiltForward, json["neck"]["tiltSideways"] | neckTiltSideways};
+    neckStream->push(json["seq"].as<uint32_t>(), json["t"].as<uint32_t>(), motionClock->now(), values);
+    automaticAnimations = false;
+    lookAtActive = false;
+  }
+  else if (json.containsKey("neck") && !json["neck"].isNull())
   {
     if (json["neck"].containsKey("rotate") && !json["neck"]["rotate"].isNull())
     {
-      neckRotate = json["neck"]["rotate"].as<double>();
+      neckRotate = json["neck"]["rotate"].as<int16_t>();
       automaticAnimations = false;
-      Serial.printf("post: neckRotate: %.2f\n", neckRotate);
+      lookAtActive = false;
+      Serial.printf("post: neckRotate: %d\n", neckRotate);
     }
     if (json["neck"].containsKey("tiltForward") && !json["neck"]["tiltForward"].isNull())
     {
-      neckTiltForward = json["neck"]["tiltForward"].as<double>();
+      neckTiltForward = json["neck"]["tiltForward"].as<int16_t>();
       automaticAnimations = false;
-      Serial.printf("post: neckTiltForward: %.2f\n", neckTiltForward);
+      lookAtActive = false;
+      Serial.printf("post: neckTiltForward: %d\n", neckTiltForward);
     }
     if (json["neck"].containsKey("tiltSideways") && !json["neck"]["tiltSideways"].isNull())
     {
-      neckTiltSideways = json["neck"]["tiltSideways"].as<double>();
+      neckTiltSideways = json["neck"]["tiltSideways"].as<int16_t>();
       automaticAnimations = false;
-      Serial.printf("post: neckTiltSideways: %.2f\n", neckTiltSideways);
+      lookAtActive = false;
+      Serial.printf("post: neckTiltSideways: %d\n", neckTiltSideways);
     }
   }
 
-  if (json.containsKey("body") && !json["body"].isNull())
+  if (stamped && json.containsKey("body") && !json["body"].isNull())
+  {
+    int16_t values[InputPlayout_VALUES] = {json["body"]["rotate"] | bodyRotate, json["body"]["tiltForward"] | bodyTiltForward, json["body"]["tiltSideways"] | bodyTiltSideways};
+    bodyStream->push(json["seq"].as<uint32_t>(), json["t"].as<uint32_t>(), motionClock->now(), values);
+    automaticAnimations = false;
+    lookAtActive = false;
+  }
+  else if (json.containsKey("body") && !json["body"].isNull())
   {
     if (json["body"].containsKey("rotate") && !json["body"]["rotate"].isNull())
     {
       bodyRotate = json["body"]["rotate"].as<int16_t>();
       automaticAnimations = false;
+      lookAtActive = false;
       Serial.printf("post: bodyRotate: %d\n", bodyRotate);
     }
     if (json["body"].containsKey("tiltForward") && !json["body"]["tiltForward"].isNull())
     {
       bodyTiltForward = json["body"]["tiltForward"].as<int16_t>();
       automaticAnimations = false;
+      lookAtActive = false;
       Serial.printf("post: bodyTiltForward: %d\n", bodyTiltForward);
     }
     if (json["body"].containsKey("tiltSideways") && !json["body"]["tiltSideways"].isNull())
     {
       bodyTiltSideways = json["body"]["tiltSideways"].as<int16_t>();
       automaticAnimations = false;
+      lookAtActive = false;
       Serial.printf("post: bodyTiltSideways: %d\n", bodyTiltSideways);
     }
   }
 
+  // Look at a point with head, neck and body together, e.g. {"lookAt": {"x": 200, "y": 0, "z": 800}}
+  if (json.containsKey("lookAt") && !json["lookAt"].isNull())
+  {
+    lookAtX = json["lookAt"]["x"] | lookAtX;
+    lookAtY = json["lookAt"]["y"] | lookAtY;
+    lookAtZ = json["lookAt"]["z"] | lookAtZ;
+    lookAtActive = true;
+    automaticAnimations = false;
+    Serial.printf("post: lookAt: %d, %d, %d\n", lookAtX, lookAtY, lookAtZ);
+  }
+
+  // Clip playback, e.g. {"clip": {"play": "/clips/hello.hyc", "loop": true, "speed": 100}}, {"clip": {"seek": 5000}} or {"clip": {"stop": true}}
+  if (json.containsKey("clip") && !json["clip"].isNull())
+  {
+    if (json["clip"].containsKey("speed") && !json["clip"]["speed"].isNull())
+    {
+      clipSpeed = json["clip"]["speed"].as<uint16_t>();
+      clipCommand = CLIP_SPEED;
+    }
+    if (json["clip"].containsKey("play") && !json["clip"]["play"].isNull())
+    {
+      strlcpy(clipPath, json["clip"]["play"].as<const char *>(), sizeof(clipPath));
+      clipLoop = json["clip"]["loop"] | false;
+      clipCommand = CLIP_PLAY;
+      Serial.printf("post: clip play: %s\n", clipPath);
+    }
+    if (json["clip"].containsKey("seek") && !json["clip"]["seek"].isNull())
+    {
+      clipSeekTime = json["clip"]["seek"].as<uint32_t>();
+      clipCommand = CLIP_SEEK;
+    }
+    if (json["clip"].containsKey("stop") && json["clip"]["stop"].as<bool>())
+    {
+      clipCommand = CLIP_STOP;
+      Serial.println("post: clip stop");
+    }
+  }
+
+  // Poses, e.g. {"pose": {"recall": "greet", "duration": 800}}, {"pose": {"save": "greet"}} or {"pose": {"delete": "greet"}}
+  if (json.containsKey("pose") && !json["pose"].isNull())
+  {
+    const char *name = nullptr;
+    if (json["pose"].containsKey("recall") && !json["pose"]["recall"].isNull())
+    {
+      name = json["pose"]["recall"].as<const char *>();
+      poseDuration = json["pose"]["duration"] | 1000;
+      poseCommand = POSE_RECALL;
+    }
+    else if (json["pose"].containsKey("save") && !json["pose"]["save"].isNull())
+    {
+      name = json["pose"]["save"].as<const char *>();
+      poseCommand = POSE_SAVE;
+    }
+    else if (json["pose"].containsKey("delete") && !json["pose"]["delete"].isNull())
+    {
+      name = json["pose"]["delete"].as<const char *>();
+      poseCommand = POSE_DELETE;
+    }
+    if (name != nullptr)
+    {
+      strlcpy(poseName, name, sizeof(poseName));
+      Serial.printf("post: pose %d: %s\n", poseCommand, poseName);
+    }
+  }
+
+  // Gestures, e.g. {"gesture": {"play": "nod", "amplitude": 30, "frequency": 2.5, "count": 3}} or {"gesture": {"stop": true}}.
+  // Amplitude in slider units, frequency in Hz, count in cycles, left out they take the default of the gesture.
+  if (json.containsKey("gesture") && !json["gesture"].isNull())
+  {
+    if (json["gesture"].containsKey("play") && !json["gesture"]["play"].isNull())
+    {
+      strlcpy(gestureName, json["gesture"]["play"].as<const char *>(), sizeof(gestureName));
+      gestureAmplitude = json["gesture"]["amplitude"] | 0;
+      gestureFrequency = (uint16_t)((json["gesture"]["frequency"] | 0.0f) * 256);
+      gestureCount = json["gesture"]["count"] | 0;
+      gestureCommand = GESTURE_PLAY;
+      Serial.printf("post: gesture play: %s\n", gestureName);
+    }
+    else if (json["gesture"]["stop"] | false)
+    {
+      gestureCommand = GESTURE_STOP;
+    }
+  }
+
+  // Centered or unlocked servos follow movement commands again
+  if (json.containsKey("automatic") || json.containsKey("neck") || json.containsKey("body") ||
+      json.containsKey("lookAt") || json.containsKey("clip") || json["pose"].containsKey("recall") || json["gesture"].containsKey("play") ||
+      json["face"].containsKey("monocle"))
+  {
+    if (servoState != SERVOS_ACTIVE)
+    {
+      servoCommand = SERVO_RESUME;
+    }
+  }
+
   r["automatic"] = automaticAnimations;
   r["face"]["eyes"]["all"] = allEyes;
   r["face"]["eyes"]["left"] = faceLeftEyeState; 
@@ -368,6 +564,30 @@ void WebServer::apiPostAction(AsyncWebServerRequest *request, uint8_t *data, siz
   r["body"]["rotate"] = bodyRotate;
   r["body"]["tiltForward"] = bodyTiltForward;
   r["body"]["tiltSideways"] = bodyTiltSideways;
+  r["clip"]["playing"] = clipPlaying;
+  r["clip"]["path"] = (const char *)clipPath;
+  r["gesture"]["active"] = gestureActive;
+  r["estimate"]["neck"]["rotate"] = estimatedPose[0];
+  r["estimate"]["neck"]["tiltForward"] = estimatedPose[1];
+  r["estimate"]["neck"]["tiltSideways"] = estimatedPose[2];
+  r["estimate"]["body"]["rotate"] = estimatedPose[3];
+  r["estimate"]["body"]["tiltForward"] = estimatedPose[4];
+  r["estimate"]["body"]["tiltSideways"] = estimatedPose[5];
+  r["stream"]["jitter"] = max(neckStream->jitter(), bodyStream->jitter()); // ms
+  r["stream"]["delay"] = max(neckStream->delay(), bodyStream->delay());    // ms
+  r["stream"]["late"] = neckStream->latePackets + bodyStream->latePackets;
+  JsonArray poses = r["poses"].to<JsonArray>();
+  for (uint8_t slot = 0; slot < PoseLibrary_MAX_POSES; slot++)
+  {
+    if (poseLibrary->name(slot) != nullptr)
+    {
+      poses.add(poseLibrary->name(slot));
+    }
+  }
+  r["lookAt"]["active"] = lookAtActive;
+  r["lookAt"]["x"] = lookAtX;
+  r["lookAt"]["y"] = lookAtY;
+  r["lookAt"]["z"] = lookAtZ;
   r["chestLightMode"] = (uint8_t)chestLightMode; 
 
   String result;
@@ -425,6 +645,11 @@ void WebServer::apiCalibratePostAction(AsyncWebServerRequest *request, uint8_t *
         }
     }
 
+  // Pulse calibration of single servo channels, the servos move to it with the next control tick
+  if (json.containsKey("servos") && !json["servos"].isNull()) {
+    readServoCalibration(json["servos"].as<JsonArrayConst>());
+  }
+
   if (json.containsKey("action") && !json["action"].isNull()) {
     String action = json["action"].as<String>();
     if (action == "save") {
@@ -432,14 +657,15 @@ void WebServer::apiCalibratePostAction(AsyncWebServerRequest *request, uint8_t *
     } else if (action == "reset") {
       resetCalibrationToDefaults(); 
     } else if (action == "set_middle_and_lock") {
-            Serial.println("Action: Set Servos to Middle and Lock (Arduino side implementation needed!)");
-            // *** IMPORTANT: You need to call your function here to physically move servos ***
-            // Example: myRobot.setAllServosToMiddle();
-        } else if (action == "unlock_servos") {
-            Serial.println("Action: Unlock Servos (Arduino side implementation needed!)");
-            // *** IMPORTANT: You need to call your function here to physically unlock servos ***
-            // Example: myRobot.unlockAllServos();
-        }
+      Serial.println("Action: Set Servos to Middle and Lock");
+      servoCommand = SERVO_CENTER_AND_LOCK;
+    } else if (action == "unlock_servos") {
+      Serial.println("Action: Unlock Servos");
+      servoCommand = SERVO_UNLOCK;
+    } else if (action == "resume_servos") {
+      Serial.println("Action: Resume Servos");
+      servoCommand = SERVO_RESUME;
+    }
   }
 
   JsonDocument r; 
@@ -450,6 +676,8 @@ void WebServer::apiCalibratePostAction(AsyncWebServerRequest *request, uint8_t *
   r["body"]["tiltForward"] = calBodyTiltForward;
   r["body"]["tiltSideways"] = calBodyTiltSideways;
     r["monocle"]["position"] = calMonoclePosition; 
+  writeServoCalibration(r, false);
+  r["servoState"] = (uint8_t)servoState; // State before a command of this request is handled
 
   String result;
   serializeJson(r, result);
@@ -467,6 +695,7 @@ void WebServer::apiGetCalibration(AsyncWebServerRequest *request) {
   r["body"]["tiltForward"] = calBodyTiltForward;
   r["body"]["tiltSideways"] = calBodyTiltSideways;
     r["monocle"]["position"] = calMonoclePosition; 
+  writeServoCalibration(r, false);
 
   String result;
   serializeJson(r, result);
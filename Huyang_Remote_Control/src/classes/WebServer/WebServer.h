@@ -5,6 +5,10 @@
     #include <ArduinoJson.h>
     #include "FS.h" // For File System
     #include "LittleFS.h" // For LittleFS
+    #include "../ServoCalibration/ServoCalibration.h" // Per-channel servo pulse calibration
+    #include "../InputPlayout/InputPlayout.h" // Playout buffer for streamed joystick packets
+    #include "../MotionClock/MotionClock.h" // Control tick clock, the playout runs on it
+    #include "../PoseLibrary/PoseLibrary.h" // Named poses on LittleFS
 
     // Define light modes (updated with new modes)
     enum LightMode {
@@ -16,6 +20,44 @@
         LIGHT_DROID_MODE_2 = 5          // Star Wars Droid indicator lights - Mode 2
     };
 
+    // Commands for the clip sequencer, handled once by the next control tick
+    enum ClipCommand {
+        CLIP_NONE = 0,
+        CLIP_PLAY = 1,
+        CLIP_STOP = 2,
+        CLIP_SPEED = 3,
+        CLIP_SEEK = 4
+    };
+
+    // Commands for the servo outputs from the calibration page, handled once by the next control tick
+    enum ServoCommand {
+        SERVO_NONE = 0,
+        SERVO_CENTER_AND_LOCK = 1,      // Every servo to 90 degrees and held there, motion stops
+        SERVO_UNLOCK = 2,               // Every servo switched off, they can be turned by hand
+        SERVO_RESUME = 3                // Servos powered again and driven by motion
+    };
+
+    enum ServoState {
+        SERVOS_ACTIVE = 0,
+        SERVOS_CENTERED = 1,
+        SERVOS_UNLOCKED = 2
+    };
+
+    // Commands for the pose library, handled once by the next control tick
+    enum PoseCommand {
+        POSE_NONE = 0,
+        POSE_RECALL = 1,
+        POSE_SAVE = 2,
+        POSE_DELETE = 3
+    };
+
+    // Commands for the gesture generator, handled once by the next control tick
+    enum GestureCommand {
+        GESTURE_NONE = 0,
+        GESTURE_PLAY = 1,
+        GESTURE_STOP = 2
+    };
+
     // --- GLOBAL VARIABLES DECLARATIONS (Accessible throughout your project) ---
     // These variables hold the current state of the robot.
     // They are updated by the WebServer and read by the HuyangRobot class (or similar).
@@ -25,9 +67,9 @@
     extern uint16_t faceLeftEyeState;  // Current state of left eye (0: none, 1: open, 2: close, 3: blink, etc.)
     extern uint16_t faceRightEyeState; // Current state of right eye
 
-    extern double neckRotate;      // Neck rotation value (-100 to 100)
-    extern double neckTiltForward; // Neck tilt forward/back value (-100 to 100)
-    extern double neckTiltSideways; // Neck tilt sideways value (-100 to 100)
+    extern int16_t neckRotate;      // Neck rotation value (-100 to 100)
+    extern int16_t neckTiltForward; // Neck tilt forward/back value (-100 to 100)
+    extern int16_t neckTiltSideways; // Neck tilt sideways value (-100 to 100)
 
     extern int16_t bodyRotate;      // Body rotation value (-100 to 100)
     extern int16_t bodyTiltForward; // Body tilt forward/back value (-100 to 100)
@@ -35,6 +77,43 @@
 
     extern int16_t monoclePosition; // Monocle servo position (e.g., 0-100, or mapped)
 
+    // Look-at point in mm from the neck pivot (x right, y up, z forward), replaces the neck/body rotate sliders while active
+    extern bool lookAtActive;
+    extern int16_t lookAtX;
+    extern int16_t lookAtY;
+    extern int16_t lookAtZ;
+
+    // Clip playback requested by the web interface and the state reported back
+    extern ClipCommand clipCommand;
+    extern char clipPath[32];       // LittleFS path of the clip, e.g. /clips/hello.hyc (see tools/clipc)
+    extern bool clipLoop;
+    extern uint16_t clipSpeed;      // Percent, 100 = as authored
+    extern uint32_t clipSeekTime;   // ms into the clip
+    extern bool clipPlaying;
+
+    // Pose requested by the web interface
+    extern PoseCommand poseCommand;
+    extern char poseName[PoseLibrary_NAME_SIZE];
+    extern uint16_t poseDuration;   // ms the recall blends from the current pose
+    extern PoseLibrary *poseLibrary; // Defined in Huyang_Remote_Control.ino, lists the stored names
+
+    // Gesture requested by the web interface, see HuyangGesture.h. 0 takes the default of the gesture.
+    extern GestureCommand gestureCommand;
+    extern char gestureName[16];     // e.g. "nod", "shake", "tilt_curious", "shrug", "startle"
+    extern int16_t gestureAmplitude; // Input units (-100 to 100)
+    extern uint16_t gestureFrequency; // Q8 Hz, 256 = 1 Hz
+    extern uint8_t gestureCount;     // Cycles
+    extern bool gestureActive;
+
+    // Pose the servos have really reached, estimated from their speed by the control tick (slider units):
+    // neck rotate, tilt forward, tilt sideways, then the same for the body
+    extern int16_t estimatedPose[6];
+
+    // Servo lock requested by the calibration page and the state reported back,
+    // any movement command on /api/post.json resumes motion
+    extern ServoCommand servoCommand;
+    extern ServoState servoState;
+
     // Calibration variables (used to adjust servo centers/ranges)
     extern int16_t calNeckRotation;
     extern int16_t calNeckTiltForward;
@@ -44,6 +123,14 @@
     extern int16_t calBodyTiltSideways; // *** FIX: Added 'extern' here! ***
     extern int16_t calMonoclePosition; 
 
+    // Pulse calibration of every servo channel (defined in Huyang_Remote_Control.ino), edited live by /api/calibrate.json
+    extern ServoCalibration *servoCalibration;
+
+    // Joystick packets stamped with "seq" and "t" (defined in Huyang_Remote_Control.ino), played out by the control tick
+    extern InputPlayout *neckStream;
+    extern InputPlayout *bodyStream;
+    extern MotionClock *motionClock; // Defined in Huyang_Remote_Control.ino, packets are stamped with its time
+
     extern LightMode chestLightMode; // Current mode for chest lights (now with more modes)
 
     class WebServer
@@ -87,6 +174,9 @@
         void loadCalibration();
         void saveCalibration();
         void resetCalibrationToDefaults();
+        // "servos": [{"channel": 5, "min": 150, "center": 372, "max": 595, "curve": 0}, ...]
+        void readServoCalibration(JsonArrayConst servos);
+        void writeServoCalibration(JsonDocument &doc, bool onlyChanged);
 
         // API action handlers
         void apiPostAction(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
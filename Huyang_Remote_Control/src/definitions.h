@@ -5,15 +5,28 @@
 #include <Arduino_GFX_Library.h>      // For TFT displays (eyes)
 #include <Adafruit_PWMServoDriver.h>  // For servo motor control
 #include "submodules/JxWifiManager/JxWifiManager.h" // For Wi-Fi management
+#include "classes/ServoCalibration/ServoCalibration.h" // Pulse calibration of every servo channel
+#include "classes/PwmFrame/PwmFrame.h"          // Frame buffer of one PCA9685 board
+#include "classes/PwmBus/PwmBus.h"              // All PCA9685 boards, shared by every servo
+#include "classes/MotionAxis/MotionAxis.h"      // Shared axis table for all eased movements
+#include "classes/MotionClock/MotionClock.h"    // Control tick clock for all motion
+#include "classes/InputFilter/InputFilter.h"    // Conditioning of the manual inputs
+#include "classes/InputPlayout/InputPlayout.h"  // Playout of streamed joystick packets
+#include "classes/PoseLibrary/PoseLibrary.h"    // Named poses on LittleFS
 #include "classes/HuyangFace/HuyangFace.h"        // For controlling the robot's face/eyes
 #include "classes/HuyangBody/HuyangBody.h"        // For controlling the robot's body movements and lights
 #include "classes/HuyangNeck/HuyangNeck.h"        // For controlling the robot's neck movements
+#include "classes/HuyangGaze/HuyangGaze.h"        // For looking at a point with neck and body
+#include "classes/HuyangGesture/HuyangGesture.h"  // For procedural gestures like nodding
+#include "classes/HuyangSequencer/HuyangSequencer.h" // For playing keyframe clips from LittleFS
 #include "classes/HuyangAudio/HuyangAudio.h"      // For audio playback
 #include "classes/WebServer/WebServer.h"          // For the web interface
 
 // Global variables for time tracking (extern declarations)
 extern unsigned long currentMillis;
 extern unsigned long previousMillisIPAdress;
+extern unsigned long previousManualInput; // Control tick time of the last changed manual input
+extern uint16_t pendingPoseDuration;      // ms of the move to a recalled pose, 0 = none pending
 
 // Wi-Fi Manager instance (extern declaration)
 extern JxWifiManager *wifi;
@@ -24,13 +37,29 @@ extern Arduino_GFX *leftEye;
 extern Arduino_DataBus *rightBus;
 extern Arduino_GFX *rightEye;
 
-// PWM Servo Driver (PCA9685) instance (extern declaration)
-extern Adafruit_PWMServoDriver *pwm;
+// Pulse calibration of every servo channel, edited by the web server and applied by the PWM bus
+extern ServoCalibration *servoCalibration;
+// Shared PWM bus of all PCA9685 boards, every servo writes into it and system.h flushes it once per loop
+extern PwmBus *pwmBus;
+// Every neck, body and monocle axis, eased by one tick per loop in system.h
+extern MotionAxis *motion;
+// Monotonic clock that decides when a control tick runs
+extern MotionClock *motionClock;
+// Deadband and smoothing of the manual inputs, applied in controlTick()
+extern InputFilter *inputFilter;
+// Named poses, recalled and saved in controlTick()
+extern PoseLibrary *poseLibrary;
+// Joystick packets from the web server, played out in controlTick()
+extern InputPlayout *neckStream;
+extern InputPlayout *bodyStream;
 
 // Huyang Robot Subsystem Instances (extern declarations)
 extern HuyangFace *huyangFace;
 extern HuyangBody *huyangBody;
 extern HuyangNeck *huyangNeck;
+extern HuyangGaze *huyangGaze;
+extern HuyangGesture *huyangGesture;
+extern HuyangSequencer *huyangSequencer;
 extern HuyangAudio *huyangAudio;
 
 // Web Server instance (extern declaration)
@@ -4,9 +4,26 @@
 #include <Arduino_GFX_Library.h>
 #include "submodules/JxWifiManager/JxWifiManager.h"
 
+#include "classes/ServoCalibration/ServoCalibration.h"
+#include "classes/PwmFrame/PwmFrame.h"
+#include "classes/PwmBus/PwmBus.h"
+#include "classes/MotionMath/MotionMath.h"
+#include "classes/MotionCurves/MotionCurves.h"
+#include "classes/MotionAxis/MotionAxis.h"
+#include "classes/MotionClock/MotionClock.h"
+#include "classes/MotionClip/MotionClip.h"
+#include "classes/MotionIdle/MotionIdle.h"
+#include "classes/InputFilter/InputFilter.h"
+#include "classes/InputPlayout/InputPlayout.h"
+#include "classes/PoseLibrary/PoseLibrary.h"
+#include "classes/ServoMixer/ServoMixer.h"
+
 #include "classes/HuyangFace/HuyangFace.h"
 #include "classes/HuyangBody/HuyangBody.h"
 #include "classes/HuyangNeck/HuyangNeck.h"
+#include "classes/HuyangGaze/HuyangGaze.h"
+#include "classes/HuyangGesture/HuyangGesture.h"
+#include "classes/HuyangSequencer/HuyangSequencer.h"
 #include "classes/HuyangAudio/HuyangAudio.h"
 
 #include "classes/WebServer/WebServer.h"
\ No newline at end of file
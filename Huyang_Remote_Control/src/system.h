@@ -31,11 +31,36 @@ void setup()
                      enableBodyRotation,
                      enableTorsoLights);
     webserver->start(); // Start the web server
+    poseLibrary->begin(); // Pose names, LittleFS is mounted by the web server
 
-    // PWM driver (PCA9685) setup
-    pwm->begin();
-    pwm->setOscillatorFrequency(27000000); // Set oscillator frequency
-    pwm->setPWMFreq(60); // Set PWM frequency for servos
+    // PWM driver (PCA9685) setup, every board of config.h
+    const uint8_t boardAddresses[] = PwmBoardAddresses;
+    for (uint8_t board = 0; board < sizeof(boardAddresses); board++)
+    {
+        if (pwmBus->addBoard(boardAddresses[board]) == PwmBus_NO_CHANNEL)
+        {
+            Serial.printf("PWM: no room for board 0x%02X, raise PwmBus_MAX_BOARDS\n", boardAddresses[board]);
+        }
+    }
+    pwmBus->begin(60, I2cClock); // Set PWM frequency for servos and the I2C clock
+
+    // Servo pulses go through the calibration loaded by the web server
+    servoCalibration->update();
+    pwmBus->setCalibration(servoCalibration);
+
+    // Input conditioning of the manual axes, a single change after ManualMoveDuration passes unfiltered
+    InputFilter::Settings headInput = {InputDeadband, InputHysteresis, InputMinCutoff, InputBeta, ManualMoveDuration};
+    InputFilter::Settings bodyInput = {InputBodyDeadband, InputHysteresis, InputMinCutoff, InputBeta, ManualMoveDuration};
+    inputFilter->configure(InputFilter::NeckRotate, headInput);
+    inputFilter->configure(InputFilter::NeckTiltForward, headInput);
+    inputFilter->configure(InputFilter::NeckTiltSideways, headInput);
+    inputFilter->configure(InputFilter::Monocle, headInput);
+    inputFilter->configure(InputFilter::BodyRotate, bodyInput);
+    inputFilter->configure(InputFilter::BodyTiltForward, bodyInput);
+    inputFilter->configure(InputFilter::BodyTiltSideways, bodyInput);
+
+    // The planner smooths over the same time at any ControlTickRate
+    motion->setTickRate(motionClock->tickRate());
 
     // Robot subsystem setup
     huyangFace->setup(); // Setup eye displays
@@ -46,6 +71,275 @@ void setup()
     Serial.println("Setup done!");
 }
 
+// One control tick: moves every servo axis to the clock time of this tick
+void controlTick()
+{
+    // Calibration changed on the web interface: new tables, and every servo is sent again
+    if (servoCalibration->update())
+    {
+        pwmBus->refreshServos();
+        motion->refresh();
+    }
+
+    // --- Servo lock state from the calibration page ---
+    switch (servoCommand)
+    {
+    case SERVO_CENTER_AND_LOCK:
+        pwmBus->centerServos();
+        pwmBus->hold();
+        servoState = SERVOS_CENTERED;
+        break;
+    case SERVO_UNLOCK:
+        pwmBus->releaseAll();
+        servoState = SERVOS_UNLOCKED;
+        break;
+    case SERVO_RESUME:
+        if (servoState != SERVOS_ACTIVE)
+        {
+            pwmBus->hold();
+            motion->refresh();
+            servoState = SERVOS_ACTIVE;
+        }
+        break;
+    default:
+        break;
+    }
+    servoCommand = SERVO_NONE;
+
+    // Centered or unlocked servos stay as they are until the next movement command
+    if (servoState != SERVOS_ACTIVE)
+    {
+        if (servoState == SERVOS_CENTERED)
+        {
+            pwmBus->centerServos(); // Follows pulse calibration changes, nothing is sent otherwise
+        }
+        pwmBus->flush();
+        return;
+    }
+
+    // --- Gestures, their layer offsets are written before the tick so they reach the servos in this pass ---
+    if (gestureCommand == GESTURE_PLAY)
+    {
+        HuyangGesture::Gesture gesture = HuyangGesture::find(gestureName);
+        if (gesture != HuyangGesture::GestureCount)
+        {
+            huyangGesture->play(gesture, gestureAmplitude, gestureFrequency, gestureCount);
+        }
+        else
+        {
+            Serial.printf("Gesture %s unknown\n", gestureName);
+        }
+    }
+    else if (gestureCommand == GESTURE_STOP)
+    {
+        huyangGesture->stop();
+    }
+    gestureCommand = GESTURE_NONE;
+    huyangGesture->tick(motionClock->now());
+    gestureActive = huyangGesture->isActive();
+
+    // --- Idle motion always runs as an additive layer, in manual mode it is only turned down ---
+    motion->setLayerWeight(MotionAxis::Idle, automaticAnimations ? MotionAxis_WEIGHT_ONE : IdleWeightManual);
+    huyangNeck->tickIdle(motionClock->now());
+    huyangBody->tickIdle(motionClock->now());
+
+    // --- Advance all servo axes (neck, body, monocle) in one pass ---
+    motion->tick(motionClock->now());
+
+    // --- Pose Library ---
+    if (poseCommand == POSE_RECALL)
+    {
+        PoseLibrary::Pose pose;
+        if (poseLibrary->recall(poseName, pose))
+        {
+            // The pose becomes the manual target and is reached in one move of poseDuration
+            neckRotate = pose.neckRotate;
+            neckTiltForward = pose.neckTiltForward;
+            neckTiltSideways = pose.neckTiltSideways;
+            monoclePosition = pose.monocle;
+            bodyRotate = pose.bodyRotate;
+            bodyTiltForward = pose.bodyTiltForward;
+            bodyTiltSideways = pose.bodyTiltSideways;
+            inputFilter->set(InputFilter::NeckRotate, neckRotate);
+            inputFilter->set(InputFilter::NeckTiltForward, neckTiltForward);
+            inputFilter->set(InputFilter::NeckTiltSideways, neckTiltSideways);
+            inputFilter->set(InputFilter::Monocle, monoclePosition);
+            inputFilter->set(InputFilter::BodyRotate, bodyRotate);
+            inputFilter->set(InputFilter::BodyTiltForward, bodyTiltForward);
+            inputFilter->set(InputFilter::BodyTiltSideways, bodyTiltSideways);
+
+            allEyes = 0;
+            faceLeftEyeState = pose.leftEye != 0 ? pose.leftEye : faceLeftEyeState;
+            faceRightEyeState = pose.rightEye != 0 ? pose.rightEye : faceRightEyeState;
+            chestLightMode = (LightMode)pose.lightMode;
+
+            automaticAnimations = false;
+            lookAtActive = false;
+            huyangSequencer->stop();
+            pendingPoseDuration = max(poseDuration, (uint16_t)1);
+        }
+        else
+        {
+            Serial.printf("Pose %s not found\n", poseName);
+        }
+    }
+    else if (poseCommand == POSE_SAVE)
+    {
+        PoseLibrary::Pose pose;
+        memset(&pose, 0, sizeof(pose));
+        pose.neckRotate = neckRotate;
+        pose.neckTiltForward = neckTiltForward;
+        pose.neckTiltSideways = neckTiltSideways;
+        pose.monocle = monoclePosition;
+        pose.bodyRotate = bodyRotate;
+        pose.bodyTiltForward = bodyTiltForward;
+        pose.bodyTiltSideways = bodyTiltSideways;
+        pose.leftEye = allEyes != 0 ? allEyes : faceLeftEyeState;
+        pose.rightEye = allEyes != 0 ? allEyes : faceRightEyeState;
+        pose.lightMode = chestLightMode;
+        if (poseLibrary->save(poseName, pose) == false)
+        {
+            Serial.printf("Pose %s not saved, all %d slots are taken\n", poseName, PoseLibrary_MAX_POSES);
+        }
+    }
+    else if (poseCommand == POSE_DELETE)
+    {
+        poseLibrary->remove(poseName);
+    }
+    poseCommand = POSE_NONE;
+
+    // --- Clip Sequencer ---
+    huyangSequencer->setCalibration(calNeckRotation, calNeckTiltForward, calNeckTiltSideways, calMonoclePosition,
+                                    calBodyRotation, calBodyTiltForward, calBodyTiltSideways);
+    switch (clipCommand)
+    {
+    case CLIP_PLAY:
+        huyangSequencer->play(clipPath, clipLoop, clipSpeed);
+        break;
+    case CLIP_STOP:
+        huyangSequencer->stop();
+        break;
+    case CLIP_SPEED:
+        huyangSequencer->setSpeed(clipSpeed);
+        break;
+    case CLIP_SEEK:
+        huyangSequencer->seek(clipSeekTime);
+        break;
+    default:
+        break;
+    }
+    clipCommand = CLIP_NONE;
+    huyangSequencer->loop();
+    clipPlaying = huyangSequencer->isPlaying();
+
+    // --- Streamed joystick packets, replayed with a small delay so Wi-Fi jitter does not reach the servos ---
+    if (neckStream->update(motion->now()))
+    {
+        neckRotate = neckStream->value(0);
+        neckTiltForward = neckStream->value(1);
+        neckTiltSideways = neckStream->value(2);
+    }
+    if (bodyStream->update(motion->now()))
+    {
+        bodyRotate = bodyStream->value(0);
+        bodyTiltForward = bodyStream->value(1);
+        bodyTiltSideways = bodyStream->value(2);
+    }
+
+    // --- Input conditioning: jitter of the web inputs is filtered out before it becomes a move ---
+    // Base layer: the sliders in manual mode, the calibrated neutral pose in automatic mode
+    inputFilter->tick(motion->now(), motionClock->delta());
+    int16_t baseNeckRotate = inputFilter->update(InputFilter::NeckRotate, automaticAnimations ? 0 : neckRotate);
+    int16_t baseNeckTiltForward = inputFilter->update(InputFilter::NeckTiltForward, automaticAnimations ? 0 : neckTiltForward);
+    int16_t baseNeckTiltSideways = inputFilter->update(InputFilter::NeckTiltSideways, automaticAnimations ? 0 : neckTiltSideways);
+    int16_t baseMonocle = inputFilter->update(InputFilter::Monocle, monoclePosition);
+    int16_t baseBodyRotate = inputFilter->update(InputFilter::BodyRotate, automaticAnimations ? 0 : bodyRotate);
+    int16_t baseBodyTiltForward = inputFilter->update(InputFilter::BodyTiltForward, automaticAnimations ? 0 : bodyTiltForward);
+    int16_t baseBodyTiltSideways = inputFilter->update(InputFilter::BodyTiltSideways, automaticAnimations ? 0 : bodyTiltSideways);
+
+    if (clipPlaying)
+    {
+        // The clip drives the base layer with the calibration added by the sequencer, idle motion is still added on top
+    }
+    else if (automaticAnimations == false && lookAtActive) // Looking at a point, re-solved every tick so a moving point is followed
+    {
+        huyangGaze->lookAt(lookAtX, lookAtY, lookAtZ);
+        huyangGaze->setCalibration(calNeckRotation, calNeckTiltForward, calBodyRotation);
+        huyangGaze->loop();
+
+        // Axes the gaze does not solve keep following their inputs
+        huyangNeck->tiltNeckSideways(baseNeckTiltSideways + calNeckTiltSideways);
+        huyangNeck->moveMonocle(baseMonocle + calMonoclePosition);
+        huyangBody->tiltBodyForward(baseBodyTiltForward + calBodyTiltForward);
+        huyangBody->tiltBodySideways(baseBodyTiltSideways + calBodyTiltSideways);
+    }
+    else
+    {
+        // Access neckRotate, calNeckRotation, etc., directly as global extern variables
+        int16_t calibratedNeckRotate = baseNeckRotate + calNeckRotation;
+        int16_t calibratedNeckTiltForward = baseNeckTiltForward + calNeckTiltForward;
+        int16_t calibratedNeckTiltSideways = baseNeckTiltSideways + calNeckTiltSideways;
+        int16_t calibratedBodyRotate = baseBodyRotate + calBodyRotation;
+        int16_t calibratedBodyTiltForward = baseBodyTiltForward + calBodyTiltForward;
+        int16_t calibratedBodyTiltSideways = baseBodyTiltSideways + calBodyTiltSideways;
+
+        // All changed axes of neck, body and monocle start and arrive together as one move
+        motion->beginMove();
+        huyangNeck->rotateHead(calibratedNeckRotate);
+        huyangNeck->tiltNeckForward(calibratedNeckTiltForward);
+        huyangNeck->tiltNeckSideways(calibratedNeckTiltSideways);
+        huyangNeck->moveMonocle(baseMonocle + calMonoclePosition);
+        huyangBody->rotateBody(calibratedBodyRotate);
+        huyangBody->tiltBodyForward(calibratedBodyTiltForward);
+        huyangBody->tiltBodySideways(calibratedBodyTiltSideways);
+
+        // A single change is one eased move, input that changes faster (joystick) is streamed:
+        // each change is queued to be reached as long after the previous one as it came in
+        unsigned long sinceInput = motion->now() - previousManualInput;
+        bool changed;
+        if (pendingPoseDuration != 0)
+        {
+            changed = motion->commitMove(pendingPoseDuration); // A recalled pose blends over its own duration
+            pendingPoseDuration = 0;
+        }
+        else if (sinceInput >= ManualMoveDuration)
+        {
+            changed = motion->commitMove(ManualMoveDuration);
+        }
+        else
+        {
+            changed = motion->queueMove(max(sinceInput, 1000UL / ControlTickRate));
+        }
+        if (changed)
+        {
+            previousManualInput = motion->now();
+        }
+    }
+
+    // --- Control Neck ---
+    huyangNeck->loop(); // Run the neck control loop
+
+    // --- Control Body ---
+    // Access chestLightMode directly, a playing clip sets the lights itself
+    if (clipPlaying == false)
+    {
+        huyangBody->currentLightMode = (HuyangBody::LightMode)chestLightMode;
+    }
+
+    huyangBody->loop(); // Run the body control loop
+
+    // Where the servos really are, reported by the web server
+    for (uint8_t direction = 0; direction < HuyangGesture_DIRECTIONS; direction++)
+    {
+        estimatedPose[direction] = huyangNeck->estimate(direction);
+        estimatedPose[HuyangGesture_DIRECTIONS + direction] = huyangBody->estimate(direction);
+    }
+
+    // Servos that have not moved for ServoHoldTime go limp, then send all servo changes of this tick in one go
+    pwmBus->release(motion->now(), ServoHoldTime);
+    pwmBus->flush();
+}
+
 void loop()
 {
     currentMillis = millis(); // Update current time
@@ -71,13 +365,63 @@ void loop()
         } else {
              Serial.println("WiFi not connected. Attempting to connect or create hotspot...");
         }
+
+        // I2C traffic of the servo driver since the last report
+        Serial.printf("PWM: %lu transactions, %lu bytes, %lu channel writes, %lu deferred board flushes, %lu skipped flushes\n",
+                      (unsigned long)pwmBus->transactions,
+                      (unsigned long)pwmBus->bytesWritten,
+                      (unsigned long)pwmBus->channelWrites,
+                      (unsigned long)pwmBus->deferredFlushes,
+                      (unsigned long)pwmBus->skippedFlushes);
+        // Bus time per flush, bucket limits double from PwmBus_HISTOGRAM_FIRST us
+        Serial.print("PWM bus time:");
+        for (uint8_t bucket = 0; bucket < PwmBus_HISTOGRAM_BUCKETS; bucket++)
+        {
+            Serial.printf(bucket < PwmBus_HISTOGRAM_BUCKETS - 1 ? " <%u:%u" : " >=%u:%u",
+                          PwmBus_HISTOGRAM_FIRST << min(bucket, (uint8_t)(PwmBus_HISTOGRAM_BUCKETS - 2)), pwmBus->busTime[bucket]);
+        }
+        Serial.printf(", max %u us\n", pwmBus->maxBusTime);
+        pwmBus->resetCounters();
+
+        // Streamed manual input since the last report
+        Serial.printf("Motion: %lu queued commands, %lu dropped, queue depth up to %u, %lu ticks faster than the servos\n",
+                      (unsigned long)motion->queuedCommands,
+                      (unsigned long)motion->droppedCommands,
+                      motion->queuePeak,
+                      (unsigned long)motion->saturatedTicks);
+        motion->resetCounters();
+
+        // Manual input changes that the conditioning held back as jitter
+        Serial.printf("Input: %lu raw changes, %lu suppressed, %lu passed\n",
+                      (unsigned long)inputFilter->rawUpdates,
+                      (unsigned long)inputFilter->suppressedUpdates,
+                      (unsigned long)inputFilter->passedUpdates);
+        inputFilter->resetCounters();
+
+        // Joystick streams: jitter, playout delay and packets that came too late or out of order
+        Serial.printf("Stream: jitter %u/%u ms, delay %u/%u ms, %lu packets, %lu late, %lu out of order, %lu extrapolated ticks\n",
+                      neckStream->jitter(), bodyStream->jitter(),
+                      neckStream->delay(), bodyStream->delay(),
+                      (unsigned long)(neckStream->packets + bodyStream->packets),
+                      (unsigned long)(neckStream->latePackets + bodyStream->latePackets),
+                      (unsigned long)(neckStream->outOfOrderPackets + bodyStream->outOfOrderPackets),
+                      (unsigned long)(neckStream->extrapolatedTicks + bodyStream->extrapolatedTicks));
+        neckStream->resetCounters();
+        bodyStream->resetCounters();
+
+        // Display traffic of the eye transitions
+        Serial.printf("Face: %lu SPI bytes in %lu lines\n",
+                      (unsigned long)huyangFace->spiBytes,
+                      (unsigned long)huyangFace->drawnSpans);
+        huyangFace->resetCounters();
     }
 
     // --- Control Face (Eyes) ---
     // Access automaticAnimations directly as it's a global extern variable
-    huyangFace->automatic = automaticAnimations; 
+    // A playing clip sets the eyes itself
+    huyangFace->automatic = automaticAnimations && clipPlaying == false;
 
-    if (automaticAnimations == false) // If manual control (access directly)
+    if (automaticAnimations == false && clipPlaying == false) // If manual control (access directly)
     {
         // Access allEyes directly as it's a global extern variable
         if (allEyes != 0) // If an "all eyes" command was sent
@@ -114,42 +458,12 @@ void loop()
     }
     huyangFace->loop(); // Run the face control loop
 
-    // --- Control Neck ---
-    // Access automaticAnimations directly
-    huyangNeck->automatic = automaticAnimations; 
-
-    if (automaticAnimations == false) // If manual control
-    {
-        // Access neckRotate, calNeckRotation, etc., directly as global extern variables
-        double calibratedNeckRotate = neckRotate + calNeckRotation;
-        double calibratedNeckTiltForward = neckTiltForward + calNeckTiltForward;
-        double calibratedNeckTiltSideways = neckTiltSideways + calNeckTiltSideways;
-
-        huyangNeck->rotateHead(calibratedNeckRotate);
-        huyangNeck->tiltNeckForward(calibratedNeckTiltForward);
-        huyangNeck->tiltNeckSideways(calibratedNeckTiltSideways);
-    }
-    huyangNeck->loop(); // Run the neck control loop
-
-    // --- Control Body ---
-    // Access automaticAnimations directly
-    huyangBody->automatic = automaticAnimations; 
-
-    if (automaticAnimations == false) // If manual control
+    // --- Control Servos ---
+    // Runs at the ControlTickRate from config.h, the rest of loop() runs on every pass
+    if (motionClock->update())
     {
-        // Access bodyRotate, calBodyRotation, etc., directly as global extern variables
-        int16_t calibratedBodyRotate = bodyRotate + calBodyRotation;
-        int16_t calibratedBodyTiltForward = bodyTiltForward + calBodyTiltForward;
-        int16_t calibratedBodyTiltSideways = bodyTiltSideways + calBodyTiltSideways;
-
-        huyangBody->rotateBody(calibratedBodyRotate);
-        huyangBody->tiltBodyForward(calibratedBodyTiltForward);
-        huyangBody->tiltBodySideways(calibratedBodyTiltSideways);
+        controlTick();
     }
-    // Access chestLightMode directly
-    huyangBody->currentLightMode = (HuyangBody::LightMode)chestLightMode;
-
-    huyangBody->loop(); // Run the body control loop
 
     // huyangAudio->loop(); // Audio loop (currently commented out)
 }
@@ -0,0 +1,683 @@
+// clipc - compiles keyframe clips for the Huyang sequencer into the binary HYC2 format (see MotionClip.h).
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I Huyang_Remote_Control/src/classes/MotionClip -o clipc tools/clipc/clipc.cpp Huyang_Remote_Control/src/classes/MotionClip/MotionClip.cpp
+//
+// Usage:
+//   clipc input.json|input.csv output.hyc [--step ms] [--index records]
+//   clipc --dump clip.hyc
+//
+// Copy the .hyc files into Huyang_Remote_Control/data/clips and upload LittleFS,
+// then play them with {"clip": {"play": "/clips/name.hyc"}} on /api/post.json.
+//
+// JSON input:
+//   {
+//     "length": 8000,
+//     "tracks": {
+//       "neckRotate": {"curve": "easeInOutSine", "keys": [[0, 0], [1000, 60], [2500, -40]]},
+//       "leftEye": {"keys": [[0, 1], [3000, 3]]}
+//     }
+//   }
+// CSV input, one key per line, the curve column is optional and applies to the whole track:
+//   time,track,value,curve
+//   1000,neckRotate,60,easeInOutSine
+//
+// Times are in ms, values use the same -100 to 100 scale as the web interface, eye and light tracks take the
+// state numbers of /api/post.json. Between two keys the track moves from the first to the second value.
+// The clip length defaults to the last key.
+//
+// The output is decoded again with the firmware decoder and compared before it is written.
+
+#include "MotionClip.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char *trackNames[MotionClip::TrackCount] = {
+		"neckRotate", "neckTiltForward", "neckTiltSideways", "monocle",
+		"bodyRotate", "bodyTiltForward", "bodyTiltSideways",
+		"leftEye", "rightEye", "chestLight"};
+
+	// Same order as MotionAxis::Curve
+	const char *curveNames[] = {
+		"linear", "easeInOutQuad", "easeInOutCubic", "easeInOutSine", "easeOutBack", "easeOutBounce", "spring"};
+	const int curveCount = sizeof(curveNames) / sizeof(curveNames[0]);
+	const int defaultCurve = 1;
+
+	struct Key
+	{
+		double time;
+		int value;
+	};
+
+	struct Track
+	{
+		int curve = defaultCurve;
+		std::vector<Key> keys;
+	};
+
+	struct Clip
+	{
+		double length = -1;
+		Track tracks[MotionClip::TrackCount];
+	};
+
+	struct Record
+	{
+		uint32_t start; // Time steps
+		uint32_t duration;
+		uint8_t track;
+		int16_t value;
+	};
+
+	[[noreturn]] void fail(const std::string &message)
+	{
+		fprintf(stderr, "clipc: %s\n", message.c_str());
+		exit(1);
+	}
+
+	int trackFromName(const std::string &name)
+	{
+		for (int i = 0; i < MotionClip::TrackCount; i++)
+		{
+			if (name == trackNames[i])
+			{
+				return i;
+			}
+		}
+		fail("unknown track '" + name + "'");
+	}
+
+	int curveFromName(const std::string &name)
+	{
+		for (int i = 0; i < curveCount; i++)
+		{
+			if (name == curveNames[i])
+			{
+				return i;
+			}
+		}
+		fail("unknown curve '" + name + "'");
+	}
+
+	bool isDiscrete(int track)
+	{
+		return track >= MotionClip::LeftEye;
+	}
+
+	// --- Minimal JSON reader, enough for the clip schema ---
+
+	struct Json
+	{
+		enum Type
+		{
+			Null,
+			Number,
+			String,
+			Array,
+			Object
+		} type = Null;
+		double number = 0;
+		std::string string;
+		std::vector<Json> items;
+		std::vector<std::pair<std::string, Json>> members;
+
+		const Json *find(const std::string &key) const
+		{
+			for (const auto &member : members)
+			{
+				if (member.first == key)
+				{
+					return &member.second;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(const std::string &text) : _text(text) {}
+
+		Json parse()
+		{
+			Json value = parseValue();
+			skipSpace();
+			if (_pos != _text.size())
+			{
+				error("trailing characters");
+			}
+			return value;
+		}
+
+	private:
+		const std::string &_text;
+		size_t _pos = 0;
+
+		[[noreturn]] void error(const std::string &message)
+		{
+			fail("JSON " + message + " at offset " + std::to_string(_pos));
+		}
+
+		void skipSpace()
+		{
+			while (_pos < _text.size() && isspace((unsigned char)_text[_pos]))
+			{
+				_pos++;
+			}
+		}
+
+		void expect(char c)
+		{
+			skipSpace();
+			if (_pos >= _text.size() || _text[_pos] != c)
+			{
+				error(std::string("expected '") + c + "'");
+			}
+			_pos++;
+		}
+
+		bool consume(char c)
+		{
+			skipSpace();
+			if (_pos < _text.size() && _text[_pos] == c)
+			{
+				_pos++;
+				return true;
+			}
+			return false;
+		}
+
+		std::string parseString()
+		{
+			expect('"');
+			std::string result;
+			while (_pos < _text.size() && _text[_pos] != '"')
+			{
+				if (_text[_pos] == '\\' && _pos + 1 < _text.size())
+				{
+					_pos++;
+				}
+				result += _text[_pos++];
+			}
+			expect('"');
+			return result;
+		}
+
+		Json parseValue()
+		{
+			skipSpace();
+			if (_pos >= _text.size())
+			{
+				error("unexpected end");
+			}
+
+			Json value;
+			char c = _text[_pos];
+			if (c == '{')
+			{
+				_pos++;
+				value.type = Json::Object;
+				if (!consume('}'))
+				{
+					do
+					{
+						std::string key = parseString();
+						expect(':');
+						value.members.emplace_back(key, parseValue());
+					} while (consume(','));
+					expect('}');
+				}
+			}
+			else if (c == '[')
+			{
+				_pos++;
+				value.type = Json::Array;
+				if (!consume(']'))
+				{
+					do
+					{
+						value.items.push_back(parseValue());
+					} while (consume(','));
+					expect(']');
+				}
+			}
+			else if (c == '"')
+			{
+				value.type = Json::String;
+				value.string = parseString();
+			}
+			else if (_text.compare(_pos, 4, "null") == 0)
+			{
+				_pos += 4;
+			}
+			else
+			{
+				char *end = nullptr;
+				value.number = strtod(_text.c_str() + _pos, &end);
+				if (end == _text.c_str() + _pos)
+				{
+					error("unexpected character");
+				}
+				value.type = Json::Number;
+				_pos = end - _text.c_str();
+			}
+			return value;
+		}
+	};
+
+	Clip readJson(const std::string &text)
+	{
+		Json root = JsonParser(text).parse();
+		if (root.type != Json::Object)
+		{
+			fail("JSON clip must be an object");
+		}
+
+		Clip clip;
+		if (const Json *length = root.find("length"))
+		{
+			clip.length = length->number;
+		}
+
+		const Json *tracks = root.find("tracks");
+		if (tracks == nullptr || tracks->type != Json::Object)
+		{
+			fail("JSON clip needs a \"tracks\" object");
+		}
+
+		for (const auto &member : tracks->members)
+		{
+			Track &track = clip.tracks[trackFromName(member.first)];
+			if (const Json *curve = member.second.find("curve"))
+			{
+				track.curve = curveFromName(curve->string);
+			}
+			const Json *keys = member.second.find("keys");
+			if (keys == nullptr || keys->type != Json::Array)
+			{
+				fail("track '" + member.first + "' needs a \"keys\" array");
+			}
+			for (const Json &key : keys->items)
+			{
+				if (key.type != Json::Array || key.items.size() != 2)
+				{
+					fail("keys of '" + member.first + "' must be [time, value] pairs");
+				}
+				track.keys.push_back({key.items[0].number, (int)lround(key.items[1].number)});
+			}
+		}
+		return clip;
+	}
+
+	Clip readCsv(const std::string &text)
+	{
+		Clip clip;
+		std::istringstream lines(text);
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(lines, line))
+		{
+			lineNumber++;
+			if (line.empty() || line[0] == '#' || line == "\r")
+			{
+				continue;
+			}
+
+			std::vector<std::string> fields;
+			std::istringstream columns(line);
+			std::string field;
+			while (std::getline(columns, field, ','))
+			{
+				field.erase(std::remove_if(field.begin(), field.end(), [](unsigned char c) { return isspace(c); }), field.end());
+				fields.push_back(field);
+			}
+
+			// Header line
+			if (lineNumber == 1 && !fields.empty() && !fields[0].empty() && !isdigit((unsigned char)fields[0][0]))
+			{
+				continue;
+			}
+			if (fields.size() < 3)
+			{
+				fail("CSV line " + std::to_string(lineNumber) + " needs time,track,value");
+			}
+
+			Track &track = clip.tracks[trackFromName(fields[1])];
+			track.keys.push_back({atof(fields[0].c_str()), atoi(fields[2].c_str())});
+			if (fields.size() > 3 && !fields[3].empty())
+			{
+				track.curve = curveFromName(fields[3]);
+			}
+		}
+		return clip;
+	}
+
+	// --- Compiler ---
+
+	uint32_t toSteps(double ms, uint16_t step)
+	{
+		return (uint32_t)lround(std::max(ms, 0.0) / step);
+	}
+
+	// Keys become moves: each one starts at the previous key of its track and arrives at its own time
+	std::vector<Record> buildRecords(Clip &clip, uint16_t step, uint32_t &lengthSteps)
+	{
+		std::vector<Record> records;
+		double lastKey = 0;
+
+		for (int t = 0; t < MotionClip::TrackCount; t++)
+		{
+			std::vector<Key> &keys = clip.tracks[t].keys;
+			std::stable_sort(keys.begin(), keys.end(), [](const Key &a, const Key &b) { return a.time < b.time; });
+
+			double previousTime = 0;
+			int previousValue = 0;
+			for (const Key &key : keys)
+			{
+				lastKey = std::max(lastKey, key.time);
+				int value = std::max(-32768, std::min(32767, key.value));
+				if (value != previousValue || key.time == 0)
+				{
+					Record record;
+					double start = isDiscrete(t) ? key.time : previousTime;
+					record.start = toSteps(start, step);
+					record.duration = isDiscrete(t) ? 0 : toSteps(key.time, step) - record.start;
+					record.track = t;
+					record.value = value;
+					records.push_back(record);
+				}
+				previousTime = key.time;
+				previousValue = value;
+			}
+		}
+
+		std::stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+			return a.start != b.start ? a.start < b.start : a.track < b.track;
+		});
+
+		lengthSteps = toSteps(clip.length >= 0 ? clip.length : lastKey, step);
+		return records;
+	}
+
+	void put16(std::vector<uint8_t> &out, uint16_t value)
+	{
+		out.push_back(value & 0xFF);
+		out.push_back(value >> 8);
+	}
+
+	void put32(std::vector<uint8_t> &out, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out.push_back((value >> (i * 8)) & 0xFF);
+		}
+	}
+
+	void putVarint(std::vector<uint8_t> &out, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		out.push_back(value);
+	}
+
+	std::vector<uint8_t> encode(const Clip &clip, const std::vector<Record> &records, uint32_t lengthSteps, uint16_t step, uint8_t interval)
+	{
+		const uint8_t trackCount = MotionClip::TrackCount;
+		const uint32_t entrySize = 8 + trackCount * 2;
+		const uint32_t indexCount = records.empty() ? 0 : (uint32_t)(records.size() - 1) / interval;
+		if (indexCount > 0xFFFF)
+		{
+			fail("too many records, use a larger --index");
+		}
+		const uint32_t recordsOffset = MotionClip_HEADER_SIZE + trackCount + indexCount * entrySize;
+
+		// Records first, the index needs their offsets
+		std::vector<uint8_t> body;
+		std::vector<uint8_t> index;
+		int16_t values[MotionClip::TrackCount] = {};
+		uint32_t previousStart = 0;
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			const Record &record = records[i];
+			if (i > 0 && i % interval == 0)
+			{
+				put32(index, previousStart * step);
+				put32(index, recordsOffset + body.size());
+				for (int t = 0; t < trackCount; t++)
+				{
+					put16(index, (uint16_t)values[t]);
+				}
+			}
+
+			int32_t change = record.value - values[record.track];
+			body.push_back(record.track);
+			putVarint(body, record.start - previousStart);
+			putVarint(body, record.duration);
+			putVarint(body, ((uint32_t)change << 1) ^ (uint32_t)(change >> 31));
+
+			values[record.track] = record.value;
+			previousStart = record.start;
+		}
+
+		std::vector<uint8_t> out;
+		for (int i = 0; i < 4; i++)
+		{
+			out.push_back(MotionClip_MAGIC[i]);
+		}
+		put32(out, lengthSteps * step);
+		put16(out, step);
+		out.push_back(trackCount);
+		out.push_back(interval);
+		put32(out, records.size());
+		put16(out, indexCount);
+		for (int t = 0; t < trackCount; t++)
+		{
+			out.push_back(clip.tracks[t].curve);
+		}
+		out.insert(out.end(), index.begin(), index.end());
+		out.insert(out.end(), body.begin(), body.end());
+		return out;
+	}
+
+	// --- Decoding with the firmware decoder ---
+
+	class MemorySource : public MotionClip::Source
+	{
+	public:
+		explicit MemorySource(const std::vector<uint8_t> &data) : _data(data) {}
+
+		size_t read(uint8_t *buffer, size_t size) override
+		{
+			size_t count = std::min(size, _data.size() - _pos);
+			std::copy(_data.begin() + _pos, _data.begin() + _pos + count, buffer);
+			_pos += count;
+			return count;
+		}
+
+		bool seek(uint32_t offset) override
+		{
+			if (offset > _data.size())
+			{
+				return false;
+			}
+			_pos = offset;
+			return true;
+		}
+
+	private:
+		const std::vector<uint8_t> &_data;
+		size_t _pos = 0;
+	};
+
+	void verify(const std::vector<uint8_t> &data, const std::vector<Record> &records, uint16_t step)
+	{
+		MemorySource source(data);
+		MotionClip decoder;
+		if (!decoder.begin(&source))
+		{
+			fail("verify: decoder rejects the header");
+		}
+
+		MotionClip::Event event;
+		for (const Record &record : records)
+		{
+			if (!decoder.next(event) || event.start != record.start * step || event.duration != record.duration * step || event.track != record.track || event.value != record.value)
+			{
+				fail("verify: decoded record differs");
+			}
+		}
+		if (decoder.next(event))
+		{
+			fail("verify: decoder returns extra records");
+		}
+
+		// After seeking to the start of every record and decoding up to it, all tracks must hold their values of that time
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			uint32_t time = records[i].start * step;
+			int16_t expected[MotionClip::TrackCount] = {};
+			size_t following = 0;
+			while (following < records.size() && records[following].start * step <= time)
+			{
+				expected[records[following].track] = records[following].value;
+				following++;
+			}
+
+			if (!decoder.seek(time))
+			{
+				fail("verify: seek to " + std::to_string(time) + " ms fails");
+			}
+			bool more = decoder.next(event);
+			while (more && event.start <= time)
+			{
+				more = decoder.next(event);
+			}
+			if (more != (following < records.size()) || (more && event.start != records[following].start * step))
+			{
+				fail("verify: seek to " + std::to_string(time) + " ms continues at the wrong record");
+			}
+
+			// The first record after time is already decoded
+			if (more)
+			{
+				expected[event.track] = event.value;
+			}
+			for (int t = 0; t < MotionClip::TrackCount; t++)
+			{
+				if (decoder.value(t) != expected[t])
+				{
+					fail("verify: seek to " + std::to_string(time) + " ms restores wrong values");
+				}
+			}
+		}
+	}
+
+	std::vector<uint8_t> readFile(const std::string &path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			fail("cannot read " + path);
+		}
+		return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+
+	int dump(const std::string &path)
+	{
+		std::vector<uint8_t> data = readFile(path);
+		MemorySource source(data);
+		MotionClip decoder;
+		if (!decoder.begin(&source))
+		{
+			fail(path + " is no HYC2 clip");
+		}
+
+		printf("%s: %u ms, %u records, %zu bytes\n", path.c_str(), decoder.length(), decoder.recordCount(), data.size());
+		MotionClip::Event event;
+		while (decoder.next(event))
+		{
+			const char *curve = event.curve < curveCount ? curveNames[event.curve] : "?";
+			printf("%8u ms  %-17s %6d  in %5u ms  %s\n", event.start, trackNames[event.track], event.value, event.duration, curve);
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.size() == 2 && args[0] == "--dump")
+	{
+		return dump(args[1]);
+	}
+
+	std::string input;
+	std::string output;
+	uint16_t step = 10;
+	int interval = 32;
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i] == "--step" && i + 1 < args.size())
+		{
+			step = (uint16_t)std::max(1, atoi(args[++i].c_str()));
+		}
+		else if (args[i] == "--index" && i + 1 < args.size())
+		{
+			interval = std::max(1, std::min(255, atoi(args[++i].c_str())));
+		}
+		else if (input.empty())
+		{
+			input = args[i];
+		}
+		else if (output.empty())
+		{
+			output = args[i];
+		}
+		else
+		{
+			fail("too many arguments");
+		}
+	}
+	if (input.empty() || output.empty())
+	{
+		fprintf(stderr, "usage: clipc input.json|input.csv output.hyc [--step ms] [--index records]\n       clipc --dump clip.hyc\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> text = readFile(input);
+	std::string source(text.begin(), text.end());
+	bool isJson = input.size() >= 5 && input.compare(input.size() - 5, 5, ".json") == 0;
+	Clip clip = isJson ? readJson(source) : readCsv(source);
+
+	uint32_t lengthSteps = 0;
+	std::vector<Record> records = buildRecords(clip, step, lengthSteps);
+	std::vector<uint8_t> data = encode(clip, records, lengthSteps, step, (uint8_t)interval);
+	verify(data, records, step);
+
+	std::ofstream file(output, std::ios::binary);
+	file.write((const char *)data.data(), data.size());
+	if (!file)
+	{
+		fail("cannot write " + output);
+	}
+
+	printf("%s: %zu records, %u ms, %zu bytes (%.1f bytes per record)\n", output.c_str(), records.size(), lengthSteps * step, data.size(),
+		   records.empty() ? 0.0 : (double)data.size() / records.size());
+	return 0;
+}
@@ -0,0 +1,136 @@
+// curvebench - accuracy and cost of the easing curve tables in MotionCurves.h against evaluating the curves directly.
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o curvebench tools/curvebench/curvebench.cpp Huyang_Remote_Control/src/classes/MotionCurves/MotionCurves.cpp
+//
+// Usage:
+//   curvebench
+//
+// Every curve is compared with the same formula in double math at every Q16 progress. The timings are host
+// timings, on the ESP8266 the double formulas cost soft-float library calls and the tables win by far more.
+// curvebench fails if a curve leaves its error bound, the bounce curve is only bounded loosely because the
+// table cuts off the tips of its cusps.
+
+#include "MotionCurves/MotionCurves.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	double easeInOutCubic(double t)
+	{
+		return t < 0.5 ? 4 * t * t * t : 1 - pow(-2 * t + 2, 3) / 2;
+	}
+
+	double easeInOutSine(double t)
+	{
+		return (1 - cos(M_PI * t)) / 2;
+	}
+
+	double easeOutBack(double t)
+	{
+		const double c1 = 1.70158;
+		double u = t - 1;
+		return 1 + (c1 + 1) * u * u * u + c1 * u * u;
+	}
+
+	double easeOutBounce(double t)
+	{
+		const double n1 = 7.5625;
+		const double d1 = 2.75;
+		if (t < 1 / d1)
+		{
+			return n1 * t * t;
+		}
+		if (t < 2 / d1)
+		{
+			t -= 1.5 / d1;
+			return n1 * t * t + 0.75;
+		}
+		if (t < 2.5 / d1)
+		{
+			t -= 2.25 / d1;
+			return n1 * t * t + 0.9375;
+		}
+		t -= 2.625 / d1;
+		return n1 * t * t + 0.984375;
+	}
+
+	double spring(double t)
+	{
+		return 1 - exp(-6 * t) * cos(2 * M_PI * 2.5 * t);
+	}
+
+	struct Curve
+	{
+		const char *name;
+		uint8_t index;
+		double (*exact)(double);
+		double bound; // Largest error in percent of the move
+	};
+
+	const Curve curves[] = {
+		{"easeInOutCubic", MotionCurves_EASE_IN_OUT_CUBIC, easeInOutCubic, 0.1},
+		{"easeInOutSine", MotionCurves_EASE_IN_OUT_SINE, easeInOutSine, 0.1},
+		{"easeOutBack", MotionCurves_EASE_OUT_BACK, easeOutBack, 0.1},
+		{"easeOutBounce", MotionCurves_EASE_OUT_BOUNCE, easeOutBounce, 3},
+		{"spring", MotionCurves_SPRING, spring, 0.6}};
+
+	template <typename Evaluate>
+	double nanosPerCall(Evaluate evaluate)
+	{
+		const uint32_t calls = 20000000;
+		volatile int32_t sink = 0;
+		uint32_t progress = 12345;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < calls; i++)
+		{
+			progress = (progress + 40503) & 0xFFFF; // Walks all progress values in a scattered order
+			sink += evaluate(progress);
+		}
+		std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+		return time.count() / calls;
+	}
+}
+
+int main()
+{
+	bool failed = false;
+
+	printf("%-16s %12s %12s %12s\n", "curve", "max error", "table", "double");
+	for (const Curve &curve : curves)
+	{
+		double error = 0;
+		for (uint32_t t = 0; t <= (uint32_t)MotionMath_ONE; t++)
+		{
+			double exact = curve.exact((double)t / MotionMath_ONE);
+			error = std::max(error, fabs((double)motionCurve(curve.index, t) / MotionMath_ONE - exact));
+		}
+		error *= 100;
+
+		double table = nanosPerCall([&](uint32_t t) { return motionCurve(curve.index, t); });
+		double direct = nanosPerCall([&](uint32_t t) { return (int32_t)(curve.exact(t / 65536.0) * MotionMath_ONE); });
+		printf("%-16s %11.3f%% %9.1f ns %9.1f ns\n", curve.name, error, table, direct);
+		failed |= error > curve.bound;
+	}
+
+	// Oscillator sine of the gestures and idle breathing, one full cycle
+	double sineError = 0;
+	for (uint32_t phase = 0; phase < 65536; phase++)
+	{
+		sineError = std::max(sineError, fabs((double)motionSine(phase) / MotionMath_ONE - sin(2 * M_PI * phase / 65536)));
+	}
+	double table = nanosPerCall([](uint32_t phase) { return motionSine(phase); });
+	double direct = nanosPerCall([](uint32_t phase) { return (int32_t)(sin(2 * M_PI * phase / 65536) * MotionMath_ONE); });
+	printf("%-16s %11.3f%% %9.1f ns %9.1f ns\n", "motionSine", sineError * 100, table, direct);
+	failed |= sineError > 0.001;
+
+	if (failed)
+	{
+		fprintf(stderr, "curvebench: a curve table is outside its error bound\n");
+		return 1;
+	}
+	return 0;
+}
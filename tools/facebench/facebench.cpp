@@ -0,0 +1,192 @@
+// facebench - SPI traffic and timing of the eye moods of HuyangFace: the original drawing, which cleared the panel
+// and drew every line, against the lid spans it keeps now (see HuyangFace.h).
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o facebench tools/facebench/facebench.cpp Huyang_Remote_Control/src/classes/HuyangFace/HuyangFace.cpp Huyang_Remote_Control/src/classes/HuyangFace/HuyangFace_moods.cpp
+//
+// Usage:
+//   facebench
+//
+// Every change between two moods is driven through setEyesTo() and loop(), with 200 us of other work per loop and
+// the panels on the GFX stand-in, which advances the host clock by the SPI time. The original drawing of the target
+// mood runs on a second pair of panels. facebench fails if the face does not end with the same pixels, if the
+// counters of HuyangFace do not match the bytes the panels received, or if the eyes open later than the original
+// did plus the rest of loop() between the frames of HuyangFace_DRAW_BUDGET.
+
+#include "HuyangFace/HuyangFace.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const uint16_t size = HOST_GFX_SIZE;
+	const uint16_t eyeColor = tftColor(255 - 255, 255 - 221, 255 - 34);
+	const uint16_t lidColor = tftColor(255, 255, 255);
+	const unsigned long loopMicros = 200; // Control tick, web server and the rest of loop()
+	const unsigned long settleMillis = 300; // Idle time after which a change counts as done, the moods wait 100 ms
+
+	const HuyangFace::EyeState moods[] = {HuyangFace::Open, HuyangFace::Closed, HuyangFace::Focus, HuyangFace::Sad, HuyangFace::Angry};
+	const char *moodNames[] = {"", "open", "closed", "", "focus", "sad", "angry"};
+
+	struct Result
+	{
+		uint32_t bytes;
+		unsigned long shownMillis; // Until the panels show the mood
+		unsigned long doneMillis;  // Until the drawing is done
+	};
+
+	void slant(Arduino_GFX &eye, bool inner, uint16_t step)
+	{
+		uint16_t length = size - 2 * step;
+		eye.drawFastHLine(inner ? size - length : 0, size - step, length, lidColor);
+	}
+
+	// The drawing the moods used before, at least one ms of _blinkDelay per step. The slant moods ran on past the middle
+	// with a wrapped length, the face keeps that half open, so the reference stops drawing there.
+	Result original(HuyangFace::EyeState mood, Arduino_GFX &left, Arduino_GFX &right)
+	{
+		unsigned long start = hostMicros;
+		left.resetCounters();
+		right.resetCounters();
+
+		uint16_t steps = mood == HuyangFace::Focus ? (size / 2) / 6 * 4 + 1 : mood == HuyangFace::Sad || mood == HuyangFace::Angry ? size + 1 : size / 2 + 1;
+		if (mood != HuyangFace::Closed)
+		{
+			left.fillScreen(eyeColor);
+			right.fillScreen(eyeColor);
+		}
+		unsigned long shown = hostMicros;
+
+		unsigned long previous = hostMicros;
+		for (uint16_t step = 0; step < steps; step++)
+		{
+			switch (mood)
+			{
+			case HuyangFace::Open:
+				for (Arduino_GFX *eye : {&left, &right})
+				{
+					eye->drawFastHLine(0, size / 2 - step, size, eyeColor);
+					eye->drawFastHLine(0, size / 2 + step, size, eyeColor);
+				}
+				break;
+			case HuyangFace::Closed:
+			case HuyangFace::Focus:
+				for (Arduino_GFX *eye : {&left, &right})
+				{
+					eye->drawFastHLine(0, step, size, lidColor);
+					eye->drawFastHLine(0, size - step, size, lidColor);
+				}
+				break;
+			default:
+				if (step <= size / 2)
+				{
+					slant(left, mood == HuyangFace::Sad, step);
+					slant(right, mood == HuyangFace::Angry, step);
+				}
+				break;
+			}
+			hostMicros = max(hostMicros, previous + 1000);
+			previous = hostMicros;
+		}
+
+		if (mood != HuyangFace::Open)
+		{
+			shown = hostMicros;
+		}
+		return {left.spiBytes + right.spiBytes, (shown - start) / 1000, (hostMicros - start) / 1000};
+	}
+
+	bool samePixels(Arduino_GFX &a, Arduino_GFX &b)
+	{
+		return memcmp(a.pixels, b.pixels, sizeof(a.pixels)) == 0;
+	}
+
+	// Changes the face to mood and runs loop() until it is done
+	Result change(HuyangFace &face, HuyangFace::EyeState mood, Arduino_GFX &left, Arduino_GFX &right,
+				  Arduino_GFX &leftExpected, Arduino_GFX &rightExpected)
+	{
+		unsigned long start = hostMicros;
+		unsigned long shown = 0;
+		unsigned long done = start;
+		left.resetCounters();
+		right.resetCounters();
+		face.resetCounters();
+
+		face.setEyesTo(mood);
+		while (hostMicros - done < settleMillis * 1000)
+		{
+			hostMicros += loopMicros;
+			face.loop();
+			if (face.isDrawing())
+			{
+				done = hostMicros;
+			}
+			if (shown == 0 && samePixels(left, leftExpected) && samePixels(right, rightExpected))
+			{
+				shown = hostMicros;
+			}
+		}
+		return {left.spiBytes + right.spiBytes, (max(shown, start) - start) / 1000, (done - start) / 1000};
+	}
+}
+
+int main()
+{
+	static Arduino_GFX left, right, leftExpected, rightExpected;
+	HuyangFace face(&left, &right);
+	face.setup();
+	face.setEyesTo(HuyangFace::Open);
+
+	bool failed = false;
+	uint32_t originalBytes = 0;
+	uint32_t faceBytes = 0;
+	printf("%-16s %21s %21s\n", "", "original", "lid spans");
+	printf("%-16s %9s %5s %5s %9s %5s %5s\n", "change", "SPI bytes", "shown", "done", "SPI bytes", "shown", "done");
+	for (HuyangFace::EyeState from : moods)
+	{
+		for (HuyangFace::EyeState to : moods)
+		{
+			if (from == to)
+			{
+				continue;
+			}
+
+			original(from, leftExpected, rightExpected);
+			change(face, from, left, right, leftExpected, rightExpected);
+
+			Result before = original(to, leftExpected, rightExpected);
+			Result now = change(face, to, left, right, leftExpected, rightExpected);
+			originalBytes += before.bytes;
+			faceBytes += now.bytes;
+
+			char name[32];
+			snprintf(name, sizeof(name), "%s -> %s", moodNames[from], moodNames[to]);
+			printf("%-16s %9u %3lums %3lums %9u %3lums %3lums\n", name, before.bytes, before.shownMillis, before.doneMillis,
+				   now.bytes, now.shownMillis, now.doneMillis);
+
+			if (samePixels(left, leftExpected) == false || samePixels(right, rightExpected) == false)
+			{
+				fprintf(stderr, "facebench: %s ends with other pixels than the original drawing\n", name);
+				failed = true;
+			}
+			if (face.spiBytes != now.bytes)
+			{
+				fprintf(stderr, "facebench: %s: HuyangFace counted %u SPI bytes, the panels got %u\n", name, face.spiBytes, now.bytes);
+				failed = true;
+			}
+			if (to == HuyangFace::Open && now.shownMillis > before.shownMillis * (HuyangFace_DRAW_BUDGET + loopMicros) / HuyangFace_DRAW_BUDGET + 1)
+			{
+				fprintf(stderr, "facebench: %s: the eyes open after %lu ms instead of %lu ms\n", name, now.shownMillis, before.shownMillis);
+				failed = true;
+			}
+		}
+	}
+	printf("all changes: %u SPI bytes originally, %u with lid spans (%.0f%%)\n", originalBytes, faceBytes, 100.0 * faceBytes / originalBytes);
+
+	if (failed)
+	{
+		return 1;
+	}
+	return 0;
+}
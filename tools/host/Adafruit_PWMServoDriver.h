@@ -0,0 +1,38 @@
+// Host stand-in for the Adafruit PCA9685 driver: setPWM() is the single channel write the firmware used before
+// PwmFrame, the set-up calls only write the registers they would write on the board.
+#ifndef Adafruit_PWMServoDriver_h
+#define Adafruit_PWMServoDriver_h
+
+#include "Arduino.h"
+#include "Wire.h"
+
+class Adafruit_PWMServoDriver
+{
+public:
+	Adafruit_PWMServoDriver(uint8_t address = 0x40, TwoWire &wire = Wire) : _address(address), _wire(&wire) {}
+
+	bool begin(uint8_t prescale = 0)
+	{
+		(void)prescale;
+		return true;
+	}
+	void setOscillatorFrequency(uint32_t frequency) { (void)frequency; }
+	void setPWMFreq(float frequency) { (void)frequency; }
+
+	uint8_t setPWM(uint8_t output, uint16_t on, uint16_t off)
+	{
+		_wire->beginTransmission(_address);
+		_wire->write(0x06 + 4 * output);
+		_wire->write(on & 0xFF);
+		_wire->write(on >> 8);
+		_wire->write(off & 0xFF);
+		_wire->write(off >> 8);
+		return _wire->endTransmission();
+	}
+
+private:
+	uint8_t _address;
+	TwoWire *_wire;
+};
+
+#endif
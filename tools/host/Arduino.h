@@ -0,0 +1,77 @@
+// Host stand-in for the parts of the Arduino core the firmware classes use, so the host tools in tools/ can build
+// them unchanged with g++. Time only moves when a tool (or the Wire stand-in) advances hostMicros.
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+#define ARDUINO_HOST 1
+
+#define PROGMEM
+#define F(text) text
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define memcpy_P memcpy
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Host clock in microseconds
+inline unsigned long hostMicros = 0;
+
+inline unsigned long micros() { return hostMicros; }
+inline unsigned long millis() { return hostMicros / 1000; }
+inline void delay(unsigned long ms) { hostMicros += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros += us; }
+inline void yield() {}
+
+inline long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+inline long random(long howsmall, long howbig) { return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall; }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Serial output is dropped unless hostVerbose is set, the firmware logs every mood and move
+inline bool hostVerbose = false;
+
+class HardwareSerial
+{
+public:
+	void begin(unsigned long) {}
+	size_t print(const char *text) { return printf("%s", text); }
+	size_t print(long value) { return printf("%ld", value); }
+	size_t println(const char *text = "") { return printf("%s\n", text); }
+	size_t println(long value) { return printf("%ld\n", value); }
+	size_t printf(const char *format, ...)
+	{
+		if (!hostVerbose)
+		{
+			return 0;
+		}
+		va_list args;
+		va_start(args, format);
+		int written = vprintf(format, args);
+		va_end(args);
+		return written;
+	}
+};
+
+inline HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,55 @@
+// Host stand-in for Arduino_GFX: keeps the pixels of a 240 x 240 panel and counts what a GC9A01 would receive
+// on SPI, so tools can check what the face shows and what it cost. hostMicros advances by the time on the bus.
+#ifndef Arduino_GFX_Library_h
+#define Arduino_GFX_Library_h
+
+#include "Arduino.h"
+
+#define HOST_GFX_SIZE 240
+#define HOST_GFX_WINDOW_BYTES 11 // Column and row address window and the memory write command
+#define HOST_GFX_SPI_CLOCK 40000000 // Default clock of Arduino_HWSPI on the ESP8266, the firmware keeps it
+
+class Arduino_GFX
+{
+public:
+	uint16_t pixels[HOST_GFX_SIZE][HOST_GFX_SIZE];
+
+	// Traffic since the last resetCounters()
+	uint32_t spiBytes = 0;
+	uint32_t windows = 0;
+
+	Arduino_GFX() { memset(pixels, 0, sizeof(pixels)); }
+
+	bool begin() { return true; }
+
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+	{
+		int16_t x0 = max<int16_t>(x, 0), y0 = max<int16_t>(y, 0);
+		int16_t x1 = min<int16_t>(x + w, HOST_GFX_SIZE), y1 = min<int16_t>(y + h, HOST_GFX_SIZE);
+		if (x0 >= x1 || y0 >= y1)
+		{
+			return;
+		}
+		for (int16_t row = y0; row < y1; row++)
+		{
+			for (int16_t column = x0; column < x1; column++)
+			{
+				pixels[row][column] = color;
+			}
+		}
+		uint32_t bytes = HOST_GFX_WINDOW_BYTES + 2 * (uint32_t)(x1 - x0) * (y1 - y0);
+		spiBytes += bytes;
+		windows++;
+		hostMicros += (uint64_t)bytes * 8 * 1000000 / HOST_GFX_SPI_CLOCK;
+	}
+	void fillScreen(uint16_t color) { fillRect(0, 0, HOST_GFX_SIZE, HOST_GFX_SIZE, color); }
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+
+	void resetCounters()
+	{
+		spiBytes = 0;
+		windows = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,87 @@
+// Host stand-in for the I2C bus. Every transaction is decoded into the register file of the PCA9685 at its
+// address (register auto-increment like MODE1 AI), counted, and hostMicros advances by its time on the wire,
+// so tools can check what the firmware sent and how long the bus was busy.
+#ifndef Wire_h
+#define Wire_h
+
+#include "Arduino.h"
+
+#define HOST_PCA9685_COUNT 4   // Boards at 0x40.. the stand-in keeps registers for
+#define HOST_I2C_START_MICROS 10 // Start, stop and the Wire library per transaction besides the byte clocks
+
+class TwoWire
+{
+public:
+	uint8_t registers[HOST_PCA9685_COUNT][256];
+
+	// Traffic since the last resetCounters()
+	uint32_t transactions = 0;
+	uint32_t bytes = 0;          // Including the address byte
+	uint32_t busMicros = 0;
+
+	TwoWire() { memset(registers, 0, sizeof(registers)); }
+
+	void begin() {}
+	void setClock(uint32_t clock) { _clock = clock; }
+
+	void beginTransmission(uint8_t address)
+	{
+		_address = address;
+		_length = 0;
+	}
+
+	size_t write(uint8_t value)
+	{
+		if (_length >= sizeof(_buffer))
+		{
+			return 0; // Like the 128 byte buffer of the ESP8266 core
+		}
+		_buffer[_length++] = value;
+		return 1;
+	}
+
+	uint8_t endTransmission(bool stop = true)
+	{
+		(void)stop;
+		uint8_t board = _address - 0x40;
+		if (board < HOST_PCA9685_COUNT && _length > 0)
+		{
+			uint8_t reg = _buffer[0];
+			for (uint8_t i = 1; i < _length; i++)
+			{
+				registers[board][reg++] = _buffer[i];
+			}
+		}
+
+		uint32_t micros = HOST_I2C_START_MICROS + (uint32_t)(1 + _length) * 9 * 1000000UL / _clock;
+		transactions++;
+		bytes += 1 + _length;
+		busMicros += micros;
+		hostMicros += micros;
+		return 0;
+	}
+
+	// OFF value of a PCA9685 output as the board holds it
+	uint16_t offValue(uint8_t address, uint8_t output)
+	{
+		const uint8_t *reg = registers[address - 0x40] + 0x06 + 4 * output;
+		return reg[2] | (reg[3] << 8);
+	}
+
+	void resetCounters()
+	{
+		transactions = 0;
+		bytes = 0;
+		busMicros = 0;
+	}
+
+private:
+	uint32_t _clock = 100000;
+	uint8_t _address = 0;
+	uint8_t _buffer[128];
+	uint8_t _length = 0;
+};
+
+inline TwoWire Wire;
+
+#endif
@@ -0,0 +1,125 @@
+// mathbench - accuracy and cost of the fixed-point easing in MotionMath.h against the double math it replaced.
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o mathbench tools/mathbench/mathbench.cpp
+//
+// Usage:
+//   mathbench
+//
+// The timings are host timings and only compare the two paths with each other. The ESP8266 has no FPU, there
+// every double operation is a library call, so the gap on the droid is much larger than the one shown here.
+// mathbench fails if the fixed-point ease is off by more than 1/65536 or a pulse by more than half a tick plus the
+// one sub-tick of rounding in the position.
+
+#include "MotionMath/MotionMath.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// Head rotation over its whole range, the way HuyangNeck drove it before MotionMath
+	const int servoMin = 150;
+	const int servoMax = 595;
+	const int rotateDegrees = 110;
+	const unsigned long duration = 1000;
+
+	double easeInOutQuad(double t)
+	{
+		return t < 0.5 ? 2 * t * t : t * (4 - 2 * t) - 1;
+	}
+
+	// Exact pulse, what both paths try to hit
+	double exactPulse(unsigned long elapsed)
+	{
+		double degree = rotateDegrees * easeInOutQuad(std::min((double)elapsed / duration, 1.0));
+		return servoMin + (servoMax - servoMin) * degree / 180;
+	}
+
+	// Before: double easing of the -100..100 input, then two Arduino map() calls that truncate to whole units
+	uint16_t doublePulse(unsigned long elapsed)
+	{
+		double percentage = std::min((double)elapsed / duration, 1.0);
+		double current = -100 + 200 * easeInOutQuad(percentage);
+		long degree = map((long)current, -100, 100, 0, rotateDegrees);
+		return (uint16_t)map(degree, 0, 180, servoMin, servoMax);
+	}
+
+	// Now: Q16 progress and ease, the position in sub-ticks and one rounding to the pulse
+	int32_t fixedStart = motionDegreeQ8ToSubticks(0, servoMin, servoMax);
+	int32_t fixedTarget = motionDegreeQ8ToSubticks(motionToQ8(rotateDegrees), servoMin, servoMax);
+
+	uint16_t fixedPulse(unsigned long elapsed)
+	{
+		uint32_t factor = motionEaseInOutQuad(motionProgress(elapsed, duration));
+		return motionSubticksToPulse(motionLerp(fixedStart, fixedTarget, factor));
+	}
+
+	template <typename Path>
+	double nanosPerCall(Path path)
+	{
+		const int rounds = 2000;
+		volatile uint32_t sink = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++)
+		{
+			for (unsigned long elapsed = 0; elapsed <= duration; elapsed++)
+			{
+				sink += path(elapsed + (sink & 1)); // The sink keeps the compiler from hoisting the calls
+			}
+		}
+		std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+		return time.count() / (rounds * (duration + 1));
+	}
+}
+
+int main()
+{
+	bool failed = false;
+
+	// Q16 ease against the double curve at every representable progress
+	double easeError = 0;
+	for (uint32_t t = 0; t <= (uint32_t)MotionMath_ONE; t++)
+	{
+		double exact = easeInOutQuad((double)t / MotionMath_ONE) * MotionMath_ONE;
+		easeError = std::max(easeError, fabs(motionEaseInOutQuad(t) - exact));
+	}
+	printf("motionEaseInOutQuad: max error %.2f / 65536\n", easeError);
+	failed |= easeError > 1;
+
+	// Pulses of a full head rotation, sampled every ms
+	double doubleError = 0;
+	double fixedError = 0;
+	int doubleSteps = 0;
+	int fixedSteps = 0;
+	uint16_t lastDouble = doublePulse(0);
+	uint16_t lastFixed = fixedPulse(0);
+	for (unsigned long elapsed = 0; elapsed <= duration; elapsed++)
+	{
+		double exact = exactPulse(elapsed);
+		uint16_t before = doublePulse(elapsed);
+		uint16_t now = fixedPulse(elapsed);
+		doubleError = std::max(doubleError, fabs(before - exact));
+		fixedError = std::max(fixedError, fabs(now - exact));
+		doubleSteps += before != lastDouble;
+		fixedSteps += now != lastFixed;
+		lastDouble = before;
+		lastFixed = now;
+	}
+	printf("head rotation, %lu ms over %d degrees:\n", duration, rotateDegrees);
+	printf("  double + map():  max error %.2f ticks, %d pulse changes\n", doubleError, doubleSteps);
+	printf("  MotionMath:      max error %.2f ticks, %d pulse changes\n", fixedError, fixedSteps);
+	failed |= fixedError > 0.5 + 1.0 / MotionMath_SUBTICKS_PER_TICK;
+
+	printf("cost per position (host):\n");
+	printf("  double + map():  %.1f ns\n", nanosPerCall(doublePulse));
+	printf("  MotionMath:      %.1f ns\n", nanosPerCall(fixedPulse));
+
+	if (failed)
+	{
+		fprintf(stderr, "mathbench: fixed-point path outside its error bound\n");
+		return 1;
+	}
+	return 0;
+}
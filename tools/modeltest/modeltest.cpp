@@ -0,0 +1,296 @@
+// modeltest - replays a manual control session through MotionAxis and checks the servo model behind estimate().
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o modeltest tools/modeltest/modeltest.cpp Huyang_Remote_Control/src/classes/MotionAxis/MotionAxis.cpp Huyang_Remote_Control/src/classes/MotionCurves/MotionCurves.cpp Huyang_Remote_Control/src/classes/PwmBus/PwmBus.cpp Huyang_Remote_Control/src/classes/PwmFrame/PwmFrame.cpp Huyang_Remote_Control/src/classes/ServoCalibration/ServoCalibration.cpp
+//
+// Usage:
+//   modeltest [session]   (default tools/modeltest/session.txt, the format is described at its top)
+//
+// The axes are the neck rotation and forward tilt (queued, timed) and the body rotation (planner) with the
+// servo dynamics of HuyangNeck and HuyangBody. The session is replayed at the ControlTickRate, commands are
+// given after MotionAxis::tick() like in system.h. Every tick checks each estimate against a double precision
+// run of the same model: first-order lag of timeConstant ms, backward Euler, capped at the servo velocity.
+// The integer model rounds its steps down, so it may trail by up to (timeConstant + dt) / dt units, and it
+// never moves faster than the servo. The lag, saturated and done lines of the session are checked on top.
+
+#include "MotionAxis/MotionAxis.h"
+#include "MotionMath/MotionMath.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const int32_t tickMillis = 16; // ControlTickRate 60
+
+	// Servo data of HuyangNeck.h and HuyangBody.h
+	const int32_t neckDegreesPerSecond = 60000 / 120; // HuyangNeck_SERVO_SPEED
+	const uint16_t neckTimeConstant = 40;            // HuyangNeck_SERVO_TIME_CONSTANT
+	const int32_t bodyDegreesPerSecond = 60000 / 200; // HuyangBody_SERVO_SPEED
+	const uint16_t bodyTimeConstant = 80;            // HuyangBody_SERVO_TIME_CONSTANT
+
+	enum AxisName
+	{
+		Rotate = 0,
+		Tilt = 1,
+		Body = 2,
+		Axes = 3
+	};
+	const char *axisNames[Axes] = {"rotate", "tilt", "body"};
+
+	struct Model
+	{
+		uint8_t index = MotionAxis_NO_AXIS;
+		int32_t velocity = 0;      // Units per second
+		uint16_t timeConstant = 0; // ms
+		double reference = 0;      // Estimate of the double precision model
+		bool saturated = false;    // Reference saturated in this tick
+		int32_t lastEstimate = 0;
+	};
+
+	// Same scaling as HuyangNeck::rotationToSubticks() and HuyangBody::rotationToSubticks()
+	int32_t neckRotation(int16_t input)
+	{
+		int32_t degree = motionMap(motionToQ8(input), motionToQ8(-100), motionToQ8(100), 0, motionToQ8(110));
+		return motionDegreeQ8ToSubticks(degree, 150, 595);
+	}
+
+	int32_t bodyRotation(int16_t input)
+	{
+		int32_t degree = motionMap(motionToQ8(input), motionToQ8(-100), motionToQ8(100), 0, motionToQ8(70));
+		return motionDegreeQ8ToSubticks(degree, 150, 595);
+	}
+
+	// Target of an input on an axis, the neck tilt runs from 0 (back) to 200 (forward) like in HuyangNeck
+	int32_t axisTarget(int axis, int16_t input)
+	{
+		switch (axis)
+		{
+		case Rotate:
+			return neckRotation(input);
+		case Tilt:
+			return motionToQ8(input + 100);
+		default:
+			return bodyRotation(input);
+		}
+	}
+
+	int axisByName(const std::string &name)
+	{
+		for (int axis = 0; axis < Axes; axis++)
+		{
+			if (name == axisNames[axis])
+			{
+				return axis;
+			}
+		}
+		fprintf(stderr, "modeltest: unknown axis %s\n", name.c_str());
+		exit(2);
+	}
+
+	// One tick of the reference: the model of MotionAxis::setDynamics() in double precision
+	void referenceTick(Model &model, double output, int32_t dt)
+	{
+		double step = (output - model.reference) * dt / (model.timeConstant + dt);
+		double limit = (double)model.velocity * dt / 1000;
+		model.saturated = fabs(step) > limit;
+		model.reference += std::max(-limit, std::min(limit, step));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "tools/modeltest/session.txt";
+	std::ifstream session(path);
+	if (!session)
+	{
+		fprintf(stderr, "modeltest: cannot read %s\n", path);
+		return 2;
+	}
+	std::vector<std::string> lines;
+	unsigned long lastTime = 0;
+	for (std::string line; std::getline(session, line);)
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		unsigned long time = strtoul(line.c_str(), nullptr, 10);
+		if (time < lastTime)
+		{
+			fprintf(stderr, "modeltest: %s is not in time order at: %s\n", path, line.c_str());
+			return 2;
+		}
+		lastTime = time;
+		lines.push_back(line);
+	}
+
+	PwmBus bus;
+	bus.addBoard(0x40);
+	MotionAxis motion(&bus);
+
+	// Set up like HuyangNeck and HuyangBody: the neck takes the joystick queue, the body has the planner
+	Model models[Axes];
+	models[Rotate] = {motion.addAxis(neckRotation(0), 8), (neckRotation(100) - neckRotation(-100)) * neckDegreesPerSecond / 110, neckTimeConstant};
+	models[Tilt] = {motion.addAxis(motionToQ8(100)), motionToQ8(200) * neckDegreesPerSecond / 100, neckTimeConstant};
+	models[Body] = {motion.addAxis(bodyRotation(0), 11), (bodyRotation(100) - bodyRotation(-100)) * bodyDegreesPerSecond / 70, bodyTimeConstant};
+	motion.enableQueue(models[Rotate].index);
+	motion.enableQueue(models[Tilt].index);
+	motion.setLimits(models[Body].index, 2400, 4800); // HuyangBody_ROTATE_MAX_VELOCITY and _ACCELERATION
+	for (Model &model : models)
+	{
+		motion.setDynamics(model.index, model.velocity, model.timeConstant);
+		model.reference = motion.estimate(model.index);
+		model.lastEstimate = motion.estimate(model.index);
+	}
+
+	unsigned long now = 0;
+	motion.tick(now);
+	motion.resetCounters();
+
+	bool passed = true;
+	size_t next = 0;
+	uint32_t referenceSaturated = 0;
+	uint32_t countedSaturated = 0; // saturatedTicks at the last saturated line
+	unsigned long doneAfter = 0;
+	unsigned long lastCommand = 0;
+	double worstDifference[Axes] = {0, 0, 0};
+	int32_t worstLag[Axes] = {0, 0, 0};
+
+	while (next < lines.size() || (doneAfter > 0 && now < lastCommand + doneAfter))
+	{
+		now += tickMillis;
+		motion.tick(now);
+
+		// Estimate of every axis against the reference and the servo velocity
+		bool saturated = false;
+		for (int axis = 0; axis < Axes; axis++)
+		{
+			Model &model = models[axis];
+			referenceTick(model, motion.output(model.index), tickMillis);
+			saturated |= model.saturated;
+
+			int32_t estimate = motion.estimate(model.index);
+			double difference = estimate - model.reference;
+			double tolerance = (double)(model.timeConstant + tickMillis) / tickMillis + 1;
+			worstDifference[axis] = std::max(worstDifference[axis], fabs(difference));
+			worstLag[axis] = std::max(worstLag[axis], abs(motion.output(model.index) - estimate));
+			if (fabs(difference) > tolerance)
+			{
+				fprintf(stderr, "modeltest: %lu ms %s: estimate %d, model %.1f\n", now, axisNames[axis], estimate, model.reference);
+				passed = false;
+			}
+			if (abs(estimate - model.lastEstimate) > std::max(model.velocity * tickMillis / 1000, (int32_t)1))
+			{
+				fprintf(stderr, "modeltest: %lu ms %s: estimate moved %d units in one tick, faster than the servo\n",
+						now, axisNames[axis], estimate - model.lastEstimate);
+				passed = false;
+			}
+			model.lastEstimate = estimate;
+		}
+		referenceSaturated += saturated;
+
+		// Commands and checks that are due, in the order of the session
+		while (next < lines.size())
+		{
+			std::istringstream line(lines[next]);
+			unsigned long time;
+			std::string command;
+			line >> time >> command;
+			if (time > now)
+			{
+				break;
+			}
+			next++;
+
+			if (command == "queue")
+			{
+				std::string name;
+				int16_t input;
+				uint16_t duration;
+				line >> name >> input >> duration;
+				int axis = axisByName(name);
+				motion.queueTo(models[axis].index, axisTarget(axis, input), duration);
+				lastCommand = now;
+			}
+			else if (command == "move")
+			{
+				uint16_t duration;
+				line >> duration;
+				motion.beginMove();
+				std::string name;
+				int16_t input;
+				while (line >> name >> input)
+				{
+					int axis = axisByName(name);
+					motion.moveTo(models[axis].index, axisTarget(axis, input), 0);
+				}
+				motion.commitMove(duration);
+				lastCommand = now;
+			}
+			else if (command == "lag")
+			{
+				std::string name;
+				int32_t expected;
+				int32_t tolerance;
+				line >> name >> expected >> tolerance;
+				Model &model = models[axisByName(name)];
+				int32_t lag = abs(motion.output(model.index) - motion.estimate(model.index));
+				printf("  %5lu ms  %-6s lag %5d, expected %d +- %d\n", now, name.c_str(), lag, expected, tolerance);
+				if (abs(lag - expected) > tolerance)
+				{
+					fprintf(stderr, "modeltest: %lu ms %s: lag %d instead of %d\n", now, name.c_str(), lag, expected);
+					passed = false;
+				}
+			}
+			else if (command == "saturated")
+			{
+				uint32_t expected;
+				uint32_t tolerance;
+				line >> expected >> tolerance;
+				uint32_t ticks = motion.saturatedTicks - countedSaturated;
+				printf("  %5lu ms  saturated %3u ticks, expected %u +- %u, model %u\n", now, ticks, expected, tolerance, referenceSaturated);
+				if (abs((int32_t)ticks - (int32_t)expected) > (int32_t)tolerance || abs((int32_t)ticks - (int32_t)referenceSaturated) > 1)
+				{
+					fprintf(stderr, "modeltest: %lu ms: %u saturated ticks instead of %u\n", now, ticks, expected);
+					passed = false;
+				}
+				countedSaturated = motion.saturatedTicks;
+				referenceSaturated = 0;
+			}
+			else if (command == "done")
+			{
+				line >> doneAfter;
+			}
+			else
+			{
+				fprintf(stderr, "modeltest: unknown command %s\n", command.c_str());
+				return 2;
+			}
+		}
+	}
+
+	for (int axis = 0; axis < Axes; axis++)
+	{
+		Model &model = models[axis];
+		printf("  %-6s servo %6d units/s, %3u ms: worst lag %5d, off the model by %.1f\n",
+			   axisNames[axis], model.velocity, model.timeConstant, worstLag[axis], worstDifference[axis]);
+		if (doneAfter > 0 && motion.estimate(model.index) != motion.output(model.index))
+		{
+			fprintf(stderr, "modeltest: %s has not settled %lu ms after the last command\n", axisNames[axis], doneAfter);
+			passed = false;
+		}
+	}
+
+	if (passed == false)
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,212 @@
+// plantest - checks that the trajectory planner of MotionAxis keeps its velocity and acceleration limits.
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o plantest tools/plantest/plantest.cpp Huyang_Remote_Control/src/classes/MotionAxis/MotionAxis.cpp Huyang_Remote_Control/src/classes/MotionCurves/MotionCurves.cpp Huyang_Remote_Control/src/classes/PwmBus/PwmBus.cpp Huyang_Remote_Control/src/classes/PwmFrame/PwmFrame.cpp Huyang_Remote_Control/src/classes/ServoCalibration/ServoCalibration.cpp
+//
+// Usage:
+//   plantest
+//
+// The axes are the body rotation and tilt of HuyangBody, with its limits, on a PwmBus over the Wire stand-in.
+// Every tick checks the raw planner against its limits:
+//   |velocity| <= maxVelocity, |velocity change| <= maxAcceleration * dt
+// and the smoothed position that reaches the servo:
+//   |step| <= maxVelocity * dt + 1 (the carried remainder of the integration), with dt averaged over the
+//   ticks of the moving average, and at a steady tick rate |change of step| <= maxAcceleration * dt² + 2.
+// Every move has to end exactly on its target without passing it. All moves run at 60 and at 100 ticks per
+// second and have to take the same time at both rates, give or take one tick of each and the rounding of the
+// moving average to whole ticks. plantest fails on the first broken bound.
+
+#include "MotionAxis/MotionAxis.h"
+#include "MotionMath/MotionMath.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	// Limits and range of the body rotation, see HuyangBody.h
+	const int32_t rotateVelocity = 2400;
+	const int32_t rotateAcceleration = 4800;
+	const int32_t tiltVelocity = 40000;
+	const int32_t tiltAcceleration = 80000;
+	const int32_t rotateMin = motionDegreeQ8ToSubticks(0, 150, 595);
+	const int32_t rotateMax = motionDegreeQ8ToSubticks(motionToQ8(70), 150, 595);
+
+	const uint16_t tickRates[] = {60, 100}; // ControlTickRate of config.h and a faster one
+	const unsigned long timeout = 10000;
+	const int scenarios = 8;
+
+	struct Axis
+	{
+		uint8_t index;
+		int32_t maxVelocity;
+		int32_t maxAcceleration;
+	};
+
+	// Ticks in the moving average of MotionAxis at a tick rate, see MotionAxis::setTickRate()
+	uint8_t smoothingTicks(uint16_t tickRate)
+	{
+		return constrain((MotionAxis_SMOOTHING_MILLIS * tickRate + 500) / 1000, 1, MotionAxis_MAX_SMOOTHING);
+	}
+
+	// Limits of one axis over one tick, returns the failed bound or nullptr
+	const char *checkTick(MotionAxis &motion, const Axis &axis, int32_t dt, int32_t window, uint8_t smoothing, bool steady,
+						  int32_t lastVelocity, int32_t lastPosition, int32_t lastStep)
+	{
+		int32_t velocity = motion.velocity(axis.index);
+		int32_t step = motion.position(axis.index) - lastPosition;
+
+		if (abs(velocity) > axis.maxVelocity)
+		{
+			return "velocity above maxVelocity";
+		}
+		if (abs(velocity - lastVelocity) > (int64_t)axis.maxAcceleration * dt / 1000)
+		{
+			return "velocity step above maxAcceleration";
+		}
+		if (abs(step) > (int64_t)axis.maxVelocity * window / (1000 * smoothing) + 1)
+		{
+			return "position step above maxVelocity";
+		}
+		if (steady && abs(step - lastStep) > (int64_t)axis.maxAcceleration * dt * dt / 1000000 + 2)
+		{
+			return "position step changed faster than maxAcceleration";
+		}
+		return nullptr;
+	}
+
+	// Runs the axis until it stands, retargets to retarget after retargetAfter ms (0 = never).
+	// jitter makes every fifth tick a missed one of twice the length. Returns the duration in ms or -1.
+	long run(const char *name, MotionAxis &motion, unsigned long &now, uint16_t tickRate, const Axis &axis,
+			 int32_t target, unsigned long retargetAfter, int32_t retarget, bool jitter)
+	{
+		int32_t tickMillis = 1000 / tickRate;
+		uint8_t smoothing = smoothingTicks(tickRate);
+		int32_t start = motion.position(axis.index);
+		int32_t from = start;
+		int32_t lastVelocity = motion.velocity(axis.index);
+		int32_t lastPosition = start;
+		int32_t lastStep = 0;
+		int32_t peakVelocity = 0;
+		unsigned long begin = now;
+		int ticks = 0;
+		int32_t dts[MotionAxis_MAX_SMOOTHING];
+		int32_t window = 0;
+		for (uint8_t i = 0; i < smoothing; i++)
+		{
+			dts[i] = tickMillis;
+			window += tickMillis;
+		}
+
+		motion.moveTo(axis.index, target, 0);
+		while (motion.isMoving(axis.index) && now - begin < timeout)
+		{
+			if (retargetAfter > 0 && now - begin >= retargetAfter)
+			{
+				from = motion.position(axis.index);
+				target = retarget;
+				retargetAfter = 0;
+				motion.moveTo(axis.index, target, 0);
+			}
+
+			int32_t dt = jitter && ticks % 5 == 4 ? 2 * tickMillis : tickMillis;
+			now += dt;
+			motion.tick(now);
+			window += dt - dts[ticks % smoothing];
+			dts[ticks % smoothing] = dt;
+			ticks++;
+
+			const char *failed = checkTick(motion, axis, dt, window, smoothing, jitter == false, lastVelocity, lastPosition, lastStep);
+			int32_t position = motion.position(axis.index);
+			if (failed == nullptr && (position - target > 0) != (from - target > 0) && position != target)
+			{
+				failed = "passed the target";
+			}
+			if (failed != nullptr)
+			{
+				fprintf(stderr, "plantest: %s: %s at tick %d (position %d, velocity %d)\n",
+						name, failed, ticks, position, motion.velocity(axis.index));
+				return -1;
+			}
+
+			peakVelocity = max(peakVelocity, abs(motion.velocity(axis.index)));
+			lastStep = position - lastPosition;
+			lastPosition = position;
+			lastVelocity = motion.velocity(axis.index);
+		}
+
+		if (motion.position(axis.index) != target || motion.isMoving(axis.index))
+		{
+			fprintf(stderr, "plantest: %s: stopped at %d instead of %d\n", name, motion.position(axis.index), target);
+			return -1;
+		}
+		printf("  %-28s %6d -> %6d  %5lu ms  peak %5d/s of %d/s\n", name, start, target, now - begin, peakVelocity, axis.maxVelocity);
+		return now - begin;
+	}
+
+	// Every move at one tick rate, fills durations with the time of each move or -1
+	void runAll(uint16_t tickRate, long durations[scenarios])
+	{
+		PwmBus bus;
+		bus.addBoard(0x40);
+		MotionAxis motion(&bus);
+		motion.setTickRate(tickRate);
+
+		Axis rotate = {motion.addAxis(rotateMin, 0), rotateVelocity, rotateAcceleration};
+		Axis tilt = {motion.addAxis(0), tiltVelocity, tiltAcceleration};
+		motion.setLimits(rotate.index, rotateVelocity, rotateAcceleration);
+		motion.setLimits(tilt.index, tiltVelocity, tiltAcceleration);
+
+		unsigned long now = 0;
+		motion.tick(now);
+
+		printf("%u ticks per second, moving average of %u ticks\n", tickRate, smoothingTicks(tickRate));
+		printf(" body rotation (sub-ticks):\n");
+		durations[0] = run("full range, reaches cruise", motion, now, tickRate, rotate, rotateMax, 0, 0, false);
+		durations[1] = run("short, never reaches cruise", motion, now, tickRate, rotate, rotateMax - 300, 0, 0, false);
+		durations[2] = run("reversed mid-move", motion, now, tickRate, rotate, rotateMin, 600, rotateMax, false);
+		durations[3] = run("retargeted further", motion, now, tickRate, rotate, rotateMin + 1000, 400, rotateMin, false);
+		durations[4] = run("missed ticks", motion, now, tickRate, rotate, rotateMax, 0, 0, true);
+		printf(" body tilt (Q8):\n");
+		durations[5] = run("full range, reaches cruise", motion, now, tickRate, tilt, motionToQ8(100), 0, 0, false);
+		durations[6] = run("reversed mid-move", motion, now, tickRate, tilt, motionToQ8(-100), 500, motionToQ8(80), false);
+		durations[7] = run("one unit", motion, now, tickRate, tilt, motion.position(tilt.index) + 1, 0, 0, false);
+	}
+}
+
+int main()
+{
+	bool passed = true;
+	long durations[2][scenarios];
+	for (int rate = 0; rate < 2; rate++)
+	{
+		runAll(tickRates[rate], durations[rate]);
+	}
+
+	// Moves end on whole ticks and the moving average spans whole ticks, so the times may differ by one tick of
+	// each rate plus how far each average is off MotionAxis_SMOOTHING_MILLIS
+	long tolerance = 0;
+	for (uint16_t tickRate : tickRates)
+	{
+		tolerance += 1000 / tickRate + abs((long)smoothingTicks(tickRate) * 1000 / tickRate - MotionAxis_SMOOTHING_MILLIS);
+	}
+	for (int scenario = 0; scenario < scenarios; scenario++)
+	{
+		if (durations[0][scenario] < 0 || durations[1][scenario] < 0)
+		{
+			passed = false;
+		}
+		else if (abs(durations[0][scenario] - durations[1][scenario]) > tolerance)
+		{
+			fprintf(stderr, "plantest: move %d takes %ld ms at %u ticks per second and %ld ms at %u\n", scenario + 1,
+					durations[0][scenario], tickRates[0], durations[1][scenario], tickRates[1]);
+			passed = false;
+		}
+	}
+
+	if (passed == false)
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,169 @@
+// pwmbench - I2C traffic of the servo outputs on the host: the single channel writes the firmware used to make
+// against the PwmFrame buffer it uses now (see PwmFrame.h).
+//
+// Build on the host, from the repository root:
+//   g++ -std=c++17 -O2 -I tools/host -I Huyang_Remote_Control/src/classes -o pwmbench tools/pwmbench/pwmbench.cpp Huyang_Remote_Control/src/classes/PwmFrame/PwmFrame.cpp Huyang_Remote_Control/src/classes/ServoCalibration/ServoCalibration.cpp
+//
+// Usage:
+//   pwmbench [--clock hz]
+//
+// Both sides run the same servo pulses through the I2C stand-in in tools/host/Wire.h, which decodes every
+// transaction into the registers of the PCA9685 and adds up the bytes and the time on the wire. After every tick
+// the registers must hold the pulses of that tick, otherwise pwmbench fails.
+
+#include "PwmFrame/PwmFrame.h"
+#include <Adafruit_PWMServoDriver.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// Outputs of the droid: monocle, neck left/right, head rotate, neck, body rotate,
+	// body forward left/right and sideways left/right (pwm_pin_* in HuyangNeck.h and HuyangBody.h)
+	const uint8_t servos[] = {4, 5, 6, 8, 9, 11, 12, 13, 14, 15};
+	const int servoCount = sizeof(servos) / sizeof(servos[0]);
+	const int ticks = 600; // 10 s at the 60 Hz control tick
+
+	struct Scenario
+	{
+		const char *name;
+		uint16_t movingMask; // Bit per entry of servos that moves
+		double hz;           // Frequency of the motion
+		double amplitude;    // Pulse ticks
+	};
+
+	const Scenario scenarios[] = {
+		{"head move", 0x001F, 0.5, 120},
+		{"whole body", 0x03FF, 0.5, 120},
+		{"idle drift", 0x03FF, 0.1, 12},
+		{"holding", 0x0000, 0, 0}};
+
+	uint16_t pulse(const Scenario &scenario, int servo, int tick)
+	{
+		double center = 372;
+		if ((scenario.movingMask & (1 << servo)) == 0)
+		{
+			return (uint16_t)center;
+		}
+		double phase = 2 * M_PI * (scenario.hz * tick / 60.0 + servo / 7.0);
+		return (uint16_t)lround(center + scenario.amplitude * sin(phase));
+	}
+
+	struct Result
+	{
+		uint32_t transactions;
+		uint32_t bytes;
+		uint32_t busMicros;
+	};
+
+	bool check(int tick, const Scenario &scenario, const char *side)
+	{
+		for (int servo = 0; servo < servoCount; servo++)
+		{
+			uint16_t expected = pulse(scenario, servo, tick);
+			uint16_t sent = Wire.offValue(0x40, servos[servo]);
+			if (sent != expected)
+			{
+				fprintf(stderr, "pwmbench: %s, %s: output %d holds %u instead of %u after tick %d\n",
+						scenario.name, side, servos[servo], sent, expected, tick);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Before PwmFrame: every moving servo wrote its channel once per tick, one transaction each
+	bool runDirect(const Scenario &scenario, Result &result)
+	{
+		Adafruit_PWMServoDriver driver(0x40, Wire);
+		memset(Wire.registers, 0, sizeof(Wire.registers));
+		for (int servo = 0; servo < servoCount; servo++)
+		{
+			driver.setPWM(servos[servo], 0, pulse(scenario, servo, 0));
+		}
+		Wire.resetCounters();
+
+		for (int tick = 1; tick < ticks; tick++)
+		{
+			for (int servo = 0; servo < servoCount; servo++)
+			{
+				if (scenario.movingMask & (1 << servo))
+				{
+					driver.setPWM(servos[servo], 0, pulse(scenario, servo, tick));
+				}
+			}
+			if (!check(tick, scenario, "direct"))
+			{
+				return false;
+			}
+		}
+		result = {Wire.transactions, Wire.bytes, Wire.busMicros};
+		return true;
+	}
+
+	// PwmFrame: every servo is set every tick, one flush sends what changed
+	bool runFrame(const Scenario &scenario, Result &result)
+	{
+		PwmFrame frame(0x40, &Wire);
+		memset(Wire.registers, 0, sizeof(Wire.registers));
+		for (int servo = 0; servo < servoCount; servo++)
+		{
+			frame.setPWM(servos[servo], pulse(scenario, servo, 0));
+		}
+		frame.flush();
+		Wire.resetCounters();
+
+		for (int tick = 1; tick < ticks; tick++)
+		{
+			for (int servo = 0; servo < servoCount; servo++)
+			{
+				frame.setPWM(servos[servo], pulse(scenario, servo, tick));
+			}
+			frame.flush();
+			if (!check(tick, scenario, "PwmFrame"))
+			{
+				return false;
+			}
+		}
+		result = {Wire.transactions, Wire.bytes, Wire.busMicros};
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t clock = 400000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--clock") == 0 && i + 1 < argc)
+		{
+			clock = strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			fprintf(stderr, "usage: pwmbench [--clock hz]\n");
+			return 1;
+		}
+	}
+	Wire.setClock(clock);
+
+	printf("%d ticks at %lu Hz I2C, per tick: transactions, bytes, bus time\n", ticks - 1, (unsigned long)clock);
+	printf("%-12s %24s %24s\n", "", "direct setPWM()", "PwmFrame");
+	for (const Scenario &scenario : scenarios)
+	{
+		Result direct;
+		Result frame;
+		if (!runDirect(scenario, direct) || !runFrame(scenario, frame))
+		{
+			return 1;
+		}
+		double n = ticks - 1;
+		printf("%-12s %6.2f %6.1f %7.0f us   %6.2f %6.1f %7.0f us\n", scenario.name,
+			   direct.transactions / n, direct.bytes / n, direct.busMicros / n,
+			   frame.transactions / n, frame.bytes / n, frame.busMicros / n);
+	}
+	return 0;
+}